@@ -45,8 +45,19 @@ auto& log = csLog::Logger::instance();
 log.stop();   // optional, called automatically on program exit
 ```
 
-> There is **no explicit initialization step**.
-> Logging macros will automatically trigger `Logger::instance()`, load YAML config, and start the worker thread.
+> Initialization is optional.
+> The first logging macro triggers `Logger::instance()` and starts the worker thread; the worker loads the YAML config, so the first log call does not pay for the parse.
+> The config path is `$CSLOG_CONFIG` if set, otherwise `CSLOG_CONFIG_PATH`. A missing or malformed file falls back to built-in defaults.
+> To pay all startup cost up front, initialize explicitly:
+>
+> ```cpp
+> csLog::LogConfig cfg;
+> cfg.level = csLog::LOG_LEVEL_INFO;
+> csLog::init(cfg);                          // or csLog::initFromFile("/etc/app/log.yaml");
+> ```
+>
+> The deferred load only overrides the keys present in the YAML file. Other edits made through `config()` before the first record are kept.
+> To change the level or queue limit at runtime, use `Logger::setLevel()` / `setMaxQueueSize()`. They refresh both the level gate and the queue capacity, and they take precedence over the same keys in the YAML file. Editing `config().level` directly does not update the published gate.
 
 ---
 
@@ -115,13 +126,13 @@ User Code → LogLine (RAII) → Logger::push() → Worker Thread → File Outpu
    LOG_INFO << "message";
    ```
 2. `LogLine` object collects message text.
-3. On destruction, `LogLine` builds a **complete JSON string**.
-4. JSON is passed to:
+3. On destruction, `LogLine` reads one clock tick and packs message, level and source location into a `LogTask`.
+4. The task is passed to:
 
    ```cpp
-   Logger::instance().push(level, jsonLine);
+   Logger::instance().push(std::move(task));
    ```
-5. The log entry is pushed into a thread-safe queue.
+5. The log entry is pushed into a thread-safe queue; the worker converts the tick and builds the JSON line.
 
 **No disk I/O happens on the user thread.**
 This keeps logging overhead extremely low.
@@ -216,11 +227,11 @@ std::condition_variable cv;
 
 If queue is full:
 
-| queuePolicy | Behavior                          |
-| ----------- | --------------------------------- |
-| `block`     | Producer waits (no logs lost)     |
-| `drop`      | Discard current log (low latency) |
-| `warn`      | Warn on console + discard         |
+| queuePolicy | Behavior                                                |
+| ----------- | ------------------------------------------------------- |
+| `block`     | Producer waits (no logs lost)                           |
+| `drop`      | Discard current log (low latency), gap record written   |
+| `warn`      | Same as `drop`, plus one stderr warning per drop streak |
 
 Choose according to system needs.
 
@@ -242,7 +253,7 @@ Ensures critical errors are not lost.
 Flush when:
 
 ```
-bytesSinceFlush >= 32 KB
+fileBuf.size() >= 32 KB
 ```
 
 ## Time-based flush
@@ -303,7 +314,7 @@ This ensures your log directory never overruns disk space — crucial on embedde
 
 # 8. Error Handling & Safety
 
-* YAML load errors → propagate exception
+* Missing or malformed YAML → warning on stderr, built-in defaults
 * File open failure → logger continues but skips file output
 * Queue overflow → depends on `queuePolicy`
 * Error logs → immediate flush
@@ -328,6 +339,565 @@ Because the worker thread is the only I/O path and is well-isolated, modifying b
 
 ---
 
+# 10. Scoped Timing Spans
+
+```cpp
+void query() {
+    LOG_SCOPE_TIMER("db.query");   // records [begin, end) and thread id on scope exit
+    ...
+}
+```
+
+* Enabled with `toTrace: true`; spans travel through the same async queue
+* The worker writes them to `{logPath}{fileName}_<time>.trace.json` in Chrome Trace Event format (open with `chrome://tracing` or Perfetto)
+* The span path never touches `ostringstream`; `name` must be a string literal
+
+---
+
+# 11. Timestamps and the Low-Latency Clock
+
+Producers read a single raw clock value (tick) in `~LogLine()` and enqueue it with the record; the worker builds the JSON line.
+
+* `clock: "system"` (default): ticks are `system_clock` nanoseconds
+* `clock: "tsc"`: producers read `rdtsc`; the worker recalibrates frequency and offset every second and converts ticks to wall time.
+  Without an invariant TSC it falls back to `CLOCK_MONOTONIC_RAW` (Linux) or `system_clock`
+
+---
+
+# 12. Output Layouts
+
+`consoleFormat` and `fileFormat` select a layout per output. Layouts are compiled once at config load and applied by the worker; when both outputs share a layout the record is formatted once.
+
+| Layout   | Example                                                        |
+| -------- | -------------------------------------------------------------- |
+| `json`   | `{"time":"2025-12-10 18:00:01","level":"INFO","msg":"ok"}`     |
+| `logfmt` | `time=2025-12-10T18:00:01.123 level=info msg=ok`               |
+| `text`   | `2025-12-10 18:00:01.123 [INFO] main.cpp:12 ok`                |
+| pattern  | `"%T.%e [%L] %s:%# %v"` → `18:00:01.123 [INFO] main.cpp:12 ok` |
+
+Pattern flags: `%Y %m %d %H %M %S`, `%F` date, `%T` time, `%e` millis, `%f` micros, `%L` / `%l` level (upper / lower case), `%s` source file name, `%g` source path, `%@` file:line, `%#` line, `%!` function, `%v` message, `%t` thread id, `%P` process id, `%q` sequence number (see `sequence`), `%%` literal percent.
+
+---
+
+# 13. Compile-Time Composed Pipeline (StaticLogger)
+
+When the outputs are known at build time, `cslog/static_logger.h` composes sinks and layouts as template parameters. The worker's sink loop is a fold expression: no virtual calls, no config branches. It is independent of the `Logger` singleton and can be used alongside it:
+
+```cpp
+#include "cslog/static_logger.h"
+
+csLog::StaticLogger<csLog::FileSink<csLog::JsonLayout>,
+                    csLog::ConsoleSink<csLog::TextLayout>>
+    feedLog({csLog::LOG_LEVEL_INFO},
+            csLog::FileSink<csLog::JsonLayout>("./logs/feed.log"),
+            csLog::ConsoleSink<csLog::TextLayout>());
+
+SLOG_INFO(feedLog)    << "tick " << seq;
+SLOG_ERROR_F(feedLog) << "gap detected";
+```
+
+* Layouts: `JsonLayout`, `LogfmtLayout`, `TextLayout`, or any type with `static void format(const LogTask&, const TimeParts&, std::string&)`
+* Sinks: any type with `write(const LogTask&, const TimeParts&)` and `flush()`
+* `FileSink` appends to a single file without rotation; see `examples/static/main.cpp`
+
+---
+
+# 14. Independent Logger Instances
+
+Besides the default singleton, a `Logger` can be constructed from a `LogConfig`. Each instance has its own config, queue, worker thread and file set, so one cannot stall another:
+
+```cpp
+csLog::LogConfig auditCfg;
+auditCfg.baseName   = "audit";
+auditCfg.durability = "fsync";      // flush + fsync after every record
+csLog::Logger audit(auditCfg);
+
+csLog::LogConfig debugCfg;
+debugCfg.baseName    = "debug";
+debugCfg.queuePolicy = "drop";
+csLog::Logger debugLog(debugCfg);
+
+LOG_INFO_TO(audit)       << "transfer id=" << id;
+LOG_DEBUG_F_TO(debugLog) << "state=" << state;
+```
+
+* `durability`: `batch` (default; flush at 32 KB / 1 s / ERROR), `record` (flush every record), `fsync` (flush + fsync every record)
+* Give each instance its own `fileName`, otherwise rotation and cleanup interfere
+
+---
+
+# 15. Slim Public Header
+
+`cslog/csLog.h` includes only a few standard headers (`<string>`, `<ostream>`, `<atomic>`, `<memory>`, ...) and exposes the macros, `LogLine` and the `Logger` front-end. Queue, thread, file and YAML handling live in `Logger::Impl` inside `csLog.cpp`.
+
+Compile-time benchmark (`bench/`; add `add_subdirectory(bench)` to the top-level `CMakeLists.txt`):
+
+```bash
+cmake --build build --target cslog_compile_bench
+# or directly
+bash bench/compile/compile_bench.sh g++ include 10
+# {"iterations":10,"tu_slim_ms":488,"tu_legacy_ms":849,"saved_ms_per_tu":361}
+```
+
+`tu_legacy.cpp` adds the headers the old public header pulled in (`<iostream>`, `<thread>`, `<yaml-cpp/yaml.h>`, ...) to compare per-TU cost.
+
+---
+
+# 16. Cold-Path Outlining
+
+Inside the loop body, a log statement leaves only a level compare (`CSLOG_UNLIKELY`) and a branch to the cold path. The `LogLine` constructors and destructor are marked `CSLOG_COLD` (`cold, noinline` on GCC / Clang, `noinline` on MSVC), so the compiler moves them, with the formatting calls, to `.text.unlikely`, out of the hot loop's instruction cache.
+
+* The `LogLine` object still lives in the enclosing function's stack frame: on x86-64 / GCC each function containing a log statement reserves about 0x2e8 extra bytes of stack and saves callee-saved registers in its prologue. The cost is at function entry, not inside the loop; stack-depth-sensitive recursive or coroutine code can use `LOG_*_LAZY` instead
+
+* The default instance gate `Logger::defaultEnabled()` does not create the instance; it stays open until the instance exists and while the config is loaded lazily
+* `LOG_*_TO(logger)` uses that instance's own gate; the `logger` expression is evaluated twice
+
+Tight-loop benchmark (`bench/hotloop/`):
+
+```bash
+cmake --build build --target cslog_hotloop_bench cslog_codesize_bench
+./bench/cslog_hotloop_bench 65536 2000
+bash bench/hotloop/codesize.sh g++ include
+# {"plain_bytes":75,"macro_bytes":135,"inline_bytes":893,"debug_gate_bytes":132,...}
+```
+
+* `plain`: no logging; `macro`: current macros; `inline`: baseline with the statement fully expanded at the call site; `debug_gate`: a filtered DEBUG statement on every iteration
+* For instruction-cache misses, run it under `perf stat -e L1-icache-load-misses`
+
+---
+
+# 17. Lazy Message Bodies (LOG_*_LAZY)
+
+Pass a callable for expensive bodies (state dumps and the like); it runs only if the record will be emitted, with no hand-written level checks:
+
+```cpp
+LOG_DEBUG_LAZY([&] { return dumpState(); });
+
+// Runs on the worker after filtering against the final config; capture by value,
+// or make sure the captured state is safe to read from the worker thread
+LOG_DEBUG_LAZY_ASYNC([snapshot] { return snapshot.toString(); });
+
+LOG_LAZY_TO(audit, csLog::LOG_LEVEL_INFO, [&] { return order.describe(); });
+
+// the macros are variadic, so capture lists with commas need no extra parentheses
+LOG_INFO_LAZY([id, &user] { return std::to_string(id) + " " + user.name(); });
+```
+
+* The callable returns a `std::string` or anything that can be streamed to `std::ostream`
+* The synchronous form runs on the producer once the level gate passes. The default instance's gate is open until its config is loaded, so call `csLog::init()` first when exact filtering matters
+* The `_ASYNC` form never runs for records dropped by a full queue or filtered on the worker
+
+---
+
+# 18. Zero-Copy Handoff
+
+`LogLine` streams through `LogStreamBuf` straight into the record body storage (see `LogText` in the next section); the destructor moves it into the `LogTask`, which is then moved into the queue. There is no `ostringstream::str()` temporary and no copy through `push(const std::string&)`.
+
+Use the rvalue overload when the string already exists:
+
+```cpp
+csLog::Logger::instance().push(csLog::LOG_LEVEL_INFO, std::move(msg));
+```
+
+Allocation-count benchmark (`bench/alloc/`; exits non-zero if the macro path allocates per record on the producer thread):
+
+```bash
+./bench/cslog_alloc_bench 100000
+# {"records":100000,"macro_allocs_per_record":0.000,...,"handoff_allocs_per_record":0.000,...,"legacy_allocs_per_record":3.000,...}
+```
+
+---
+
+# 19. Inline Record Bodies and a Contiguous Queue
+
+`LogTask::text` is a `LogText`. Bodies up to 256 bytes (`LogText::INLINE_CAPACITY`) live inside the record; longer ones spill to a heap `std::string` (a `std::string&&` argument hands over its buffer). The queue is a contiguous ring array reserved up front for `maxQueueSize` records, with `LogTask`s stored directly in its slots. A typical record never touches the allocator between `<<` and the write; enqueueing is a single memcpy of the actual length.
+
+Memory and latency benchmark (`bench/record/`):
+
+```bash
+./bench/cslog_record_bench 200000
+# {"records":200000,"sizeof_log_task":408,"inline_capacity":256,
+#  "ring_slots":201000,"ring_bytes":82008000,"ring_reserve_ns":45150314,
+#  "short_allocs_per_record":0.000,...,"short_p50_ns":435,"short_p99_ns":8693,...,"short_max_ns":1716437,
+#  "long_allocs_per_record":1.000,...,"long_p50_ns":514,"long_p99_ns":8263,...,"long_max_ns":1518830}
+```
+
+* Storage for `maxQueueSize × sizeof(LogTask)` is reserved at startup (and when `setMaxQueueSize()` raises the limit), roughly 8 MB for the default 20000. The allocation happens outside the queue lock, so producers never hit a resize while holding it; lower `maxQueueSize` if memory is tight
+* `ring_reserve_ns` is the one-off cost of reserving that storage and `*_max_ns` the worst single call; neither is folded into the percentiles
+
+---
+
+# 20. Producer Latency Benchmark (cslog_bench)
+
+`bench/latency/` builds `cslog_bench`. It runs every combination of macro family (`plain`, `file_line` for `_F`, `disabled` for level-filtered calls), producer thread count (1, 2, 4, … 64) and `queuePolicy` (block / drop / warn). Each call's latency goes into a `csLog::LatencyHistogram` (`cslog/histogram.h`: HDR-style log-linear buckets, relative error ≤ 1/32), and the results are printed as a JSON array:
+
+```bash
+./bench/cslog_bench 20000 64 ./bench_logs/
+# [
+#   {"family":"plain","policy":"block","threads":1,"records":20000,
+#    "p50_ns":591,"p99_ns":5247,"p999_ns":32255,"max_ns":895272,"mean_ns":1748.5,
+#    "produce_per_sec":532960,"drained_per_sec":531700},
+#   ...
+# ]
+```
+
+* Each call is timed with a pair of `steady_clock` reads; their own cost (about 20 ns) is included
+* `produce_per_sec` covers the producer phase only; `drained_per_sec` also includes `stop()` draining the queue and finishing the file
+* Logs really are written to `log_dir`; stderr warnings from the `warn` policy are discarded during the run
+
+---
+
+# 21. Disk Throughput Benchmark and Runtime Stats
+
+`Logger::stats()` returns a `LogStats` snapshot with these counters:
+
+* enqueued / dropped / blocked-wait counts
+* records and bytes written
+* rotations
+* current and maximum queue depth
+
+With `workerTiming: true` it also accumulates the worker's time in format / write / flush / rotate.
+
+```cpp
+csLog::LogStats st = csLog::Logger::instance().stats();
+```
+
+`bench/disk/` builds `cslog_disk_bench`. It writes at a given rate and record size through the real file path, with rotation and total-size cleanup active, and prints one JSON object:
+
+```bash
+# rate(0=unlimited) record_bytes seconds threads dir file_MB total_MB stall_us
+./bench/cslog_disk_bench 0 200 3 4 ./bench_logs/ 4 32 100
+# {"rate_per_sec":0,"record_bytes":200,...,"rotations":52,
+#  "mb_written":211.49,"mb_per_sec":70.10,"records_per_sec":313436,...,
+#  "worker_ms":{"format":673.8,"write":92.6,"flush":109.4,"rotate":33.5,"total":909.3},
+#  "producer_ns":{"p50":367,"p99":98303,"p999":2555903,"max":19599569},
+#  "stalls":{"threshold_us":100,"count":7925,"during_rotation":1332,...},
+#  "queue_depth":[[100,20000],[200,20000],...]}
+```
+
+* `queue_depth` is the maximum depth in each 100 ms window. `stalls.during_rotation` counts producer stalls that overlap a sampling window in which a rotation happened
+* When several rotations happen within one second, the new file name gets a sequence suffix (`{fileName}_{time}_{seq}.log`)
+
+---
+
+# 22. Worker Profiling (CSLOG_PROFILE_WORKER)
+
+When `csLog.cpp` is compiled with `CSLOG_PROFILE_WORKER` (e.g. `target_compile_definitions(cslog PRIVATE CSLOG_PROFILE_WORKER)`), the worker records per-stage TSC cycles (nanoseconds where there is no TSC) into lock-free `csLog::AtomicHistogram`s:
+
+| Stage | Covers |
+| --- | --- |
+| `dequeue` | lock + pop, excluding idle waiting |
+| `console` / `file_buffer` | console output / per-record append to the file buffer |
+| `file_write` | the `fwrite` + `fflush` syscalls that write the file buffer out |
+| `flush` | each whole flush, including its `file_write` (plus `fsync` in `fsync` mode) |
+| `rotate` | a whole rotation, including its `flush` / `cleanup` / `create_file` |
+| `create_file` / `cleanup` | `createNewLogFile()` / `cleanupOldLogFiles()` |
+
+They can be read at any time and are dumped to stderr on `stop()`:
+
+```cpp
+csLog::LatencyHistogram h;
+if (logger.workerProfile(csLog::WorkerStage::Rotate, h)) {
+    auto p99 = h.percentile(0.99);
+}
+```
+
+```
+[PROFILE] 日志后台线程各阶段耗时（TSC 周期）: cslog_disk_bench
+  dequeue count=369524 mean=170 p50=139 p99=223 p999=751 max=2208316
+  file_buffer count=369558 mean=82 p50=50 p99=93 p999=151 max=2285728
+  file_write count=2644 mean=49701 p50=31231 p99=208895 p999=2293759 max=2578868
+  flush count=2645 mean=50337 p50=31743 p99=208895 p999=2293759 max=2580934
+  rotate count=20 mean=1094624 p50=1081343 p99=1835007 p999=1835007 max=2626288
+  ...
+```
+
+Without the macro the probes compile to nothing and `workerProfile()` returns `false`.
+
+---
+
+# 23. Producer-Side Latency Sampling (latencySampleEvery)
+
+```yaml
+latencySampleEvery: 100   # sample one LogLine per 100 on each thread; 0 disables
+latencyReportSec: 60
+```
+
+A sampled `LogLine` is timed in four segments:
+
+* construction, including `ostream` setup
+* `<<` streaming
+* destructor finishing: timestamp, body, newline trimming
+* `push()`, including waiting under the `block` policy
+
+Samples go into lock-free histograms. Every `latencyReportSec` seconds the worker summarizes them into one INFO record, written alongside regular logs:
+
+```
+producer_latency_ns samples=114700 every=10 construct_p50=151 construct_p99=287 construct_max=2357087 stream_p50=119 ... push_p50=107 push_p99=1215 push_max=8593397
+```
+
+* A call that is not sampled costs only one thread-local counter increment. When sampling is off, no histograms are allocated
+* `LOG_*_LAZY` and direct `Logger::push()` calls are not sampled
+
+---
+
+# 24. Prometheus Metrics Export (metricsFile)
+
+```yaml
+metricsFile: "/var/lib/node_exporter/textfile/cslog.prom"
+metricsIntervalSec: 10
+```
+
+Every `metricsIntervalSec` seconds the worker writes `Logger::stats()` in Prometheus text format. It writes a `.tmp` file first and then `rename`s it into place, so readers never see a partial file. One final write happens on stop. Point node_exporter's textfile collector at the directory to scrape it:
+
+```
+cslog_records_total{logger="svc",level="info"} 1001
+cslog_dropped_total{logger="svc"} 0
+cslog_blocked_seconds_total{logger="svc"} 0
+cslog_queue_depth_max{logger="svc"} 1933
+cslog_flush_seconds_total{logger="svc"} 8.18e-05
+```
+
+* Exported series: `records_total{level}`, `enqueued_total`, `dropped_total`, `blocked_total`, `blocked_seconds_total`, `queue_depth`, `queue_depth_max`, `bytes_written_total`, `rotations_total`, `flushes_total`, `flush_seconds_total`
+* The `logger` label is `baseName`; give each instance its own `metricsFile` when several share a directory
+* All values come from existing atomics; the producer path gets no extra work
+
+---
+
+# 25. Hot Callsite Report (callsiteReportSec)
+
+```yaml
+callsiteReportSec: 60   # 0 disables
+callsiteTopN: 10
+```
+
+Each log statement carries a static `CallSite` (`__FILE__` / `__LINE__`) created where the macro expands. It is constant-initialized and costs nothing at run time, and it travels with the record into the queue.
+The worker accumulates records and output bytes per callsite. Every `callsiteReportSec` seconds it emits the `callsiteTopN` busiest callsites as one INFO record, then resets the counts:
+
+```
+hot_callsites window_s=60 sites=37 records=571862 bytes=40991067 | src/feed.cpp:118 records=519391 bytes=34354757 pct=90.8 | src/order.cpp:42 records=51941 bytes=6604004 pct=9.1 | ...
+```
+
+* Counting happens on the single worker thread, so producers do no extra atomic operations
+* Only records that are actually written are counted. Records filtered by level or dropped on a full queue are not
+* Records from direct `Logger::push()` calls are grouped under `<push>`; the logger's own diagnostics (including this summary) and gap markers are not counted
+
+---
+
+# 26. Adaptive Callsite Rate Limiting (callsiteRateLimit)
+
+```yaml
+callsiteRateLimit: 1000   # max records per second per callsite; 0 disables
+```
+
+Once per second the worker checks each callsite's rate. When a statement goes over the limit, its `CallSite` is switched to let through one record in every N, where N = rate / limit rounded up. A WARN record is written once:
+
+```
+callsite src/feed.cpp:118 ~353554 records/s exceeds callsiteRateLimit=1000, now emitting 1 in 354
+```
+
+While a callsite is limited, N is adjusted every second to track its actual rate. When the rate falls below half the limit, full output resumes and an INFO record reports how many records were skipped (the messages are written in Chinese).
+
+* A statement that is not being limited pays one relaxed atomic load
+* Skipped statements are neither queued nor formatted, but the expressions on the right of `<<` are still evaluated
+* For `LOG_*_LAZY`, skipped records never invoke the callable
+* Other callsites are unaffected, so a log storm from one buggy statement no longer fills `maxQueueSize` and blocks every thread
+* `CallSite` is a per-statement global, so a statement that writes to several Loggers shares one sampling state across all of them
+
+---
+
+# 27. Per-Level Rate Limiting (levelRateLimit)
+
+```yaml
+levelRateLimit:
+  info:  { perSec: 50000, burst: 200000 }
+  debug: { perSec: 10000 }          # burst defaults to perSec
+rateLimitReportSec: 10
+```
+
+Each level has its own token bucket, checked on the producer when the `LogLine` is constructed. Records over the limit are never formatted or queued; they are only counted.
+The bucket is implemented as GCRA: one atomic timestamp per level, refilled lazily from elapsed time on each take. No timer thread is needed.
+When a window had drops, the worker writes one WARN summary:
+
+```
+rate_limited window_s=10 info=4412244
+```
+
+* Unlike `queuePolicy: drop`, the limit applies before the queue fills up, so CPU and disk usage have a fixed upper bound
+* Running totals are available in `LogStats::rateLimited[]` and the Prometheus metric `cslog_rate_limited_total{level}`
+* The limit applies to the `LOG_*` and `LOG_*_LAZY` macros. Records from direct `Logger::push()` calls are not limited
+
+---
+
+# 28. Drop Gap Records and Sequence Numbers (sequence)
+
+When the queue is full under the `drop` / `warn` policies, the enqueue side only counts the drops and remembers when the first one happened. It no longer writes to stderr for every dropped record.
+Once space frees up, a WARN gap record is queued ahead of the next record. If the queue drains with no new record, the worker adds the gap record itself. Gap records are never filtered by level:
+
+```
+{"time":"2026-10-17 13:58:57","level":"WARN","dropped":28083,"since":"2026-10-17 13:58:57.669"}
+```
+
+`logfmt`, `text` and pattern layouts render it as `dropped=28083 since=...`.
+
+```yaml
+sequence: true
+```
+
+With `sequence` on, every record carries its enqueue sequence number:
+
+| Layout  | Field   |
+| ------- | ------- |
+| json    | `"seq"` |
+| logfmt  | `seq=`  |
+| text    | `#N`    |
+| pattern | `%q`    |
+
+Dropped records also use up a sequence number, so downstream tools can find losses from gaps in the sequence without relying on gap records.
+
+---
+
+# 29. Internal Diagnostics Channel
+
+The logger's own records no longer pass through the producer queue. A separate lock-free channel carries them to the worker:
+
+* new log file, cleanup of old files (including failed deletions), failure to open a file
+* the `producer_latency_ns` / `hot_callsites` / `rate_limited` summaries and the callsite throttling notices
+
+Any thread pushes onto a Treiber stack with CAS. Before taking a queued record, the worker takes the whole stack and restores FIFO order. Diagnostics are written ahead of queued records.
+They still go through level filtering and formatting. They do not take queue slots, and they are not subject to `queuePolicy`, rate limits or sequence numbers.
+Under the `block` policy with a full queue, the new-file notice written during rotation can no longer leave the worker waiting for space it is supposed to free itself.
+
+---
+
+# 30. Disk-Full and I/O Errors (Degraded Mode)
+
+```yaml
+degradedBufferSize: 8388608   # memory cap for records held while degraded (bytes)
+```
+
+Formatted records are appended to the worker's own file buffer and written with one `fwrite` per flush. stdio no longer adds its own buffering, so on a failure the worker knows exactly which bytes did not reach the disk.
+When an open, write, flush or `fsync` fails:
+
+1. The half-written line is truncated away and the failing file is closed. If nothing was written to it, the empty file is deleted. One notice goes to `stderr` and one to the diagnostics channel.
+2. The logger enters degraded mode. New records and any unwritten content are held in memory line by line. When the buffer exceeds `degradedBufferSize`, the **oldest** lines are dropped.
+3. Retries back off starting at 100 ms, doubling each time, up to 30 s. On `ENOSPC` / `EDQUOT`, the oldest log file is deleted first to free space.
+4. Once a new file opens and the whole buffer has been written back, normal operation resumes and an INFO record is written:
+
+```
+日志文件恢复写入：./logs/server_2026-10-17_14-04-23.log，补写 2900 行，降级期间丢弃最旧的 15511 行
+```
+
+This record says the log file has resumed writing, with 2900 lines written back and 15511 of the oldest lines dropped while degraded.
+
+If the logger is still degraded when `stop()` is called, it tries to resume one more time.
+
+The matching `LogStats` fields and Prometheus metrics:
+
+| Field | Metric |
+| --- | --- |
+| `ioErrors` | `cslog_io_errors_total` |
+| `degraded` | `cslog_degraded` |
+| `degradedEntries` | `cslog_degraded_entries_total` |
+| `degradedBuffered` | `cslog_degraded_buffer_bytes` |
+| `degradedDropped` | `cslog_degraded_dropped_total` |
+| `emergencyDeletes` | `cslog_emergency_deletes_total` |
+
+---
+
+# 31. Flush Barrier and Bounded Shutdown
+
+```cpp
+using namespace std::chrono;
+
+// true once every record queued before the call is written and fsynced
+bool durable = logger.flush(milliseconds(200));
+
+// write for at most 2 more seconds, then drop the rest; returns the number dropped
+uint64_t lost = logger.stop(steady_clock::now() + seconds(2));
+```
+
+* `flush(timeout)` records how many records were queued at the time of the call. Once the worker has written all of them, it `fsync`s the log file.
+  It returns `false` on timeout, while degraded, after `stop()`, or when called on the worker thread (for example inside a `_LAZY_ASYNC` callable).
+* `stop()` is unchanged. It returns only after every queued record is written.
+* `stop(deadline)` drops whatever is still queued once the deadline passes, writes one WARN record and exits. If the logger is still degraded, it does not retry, and the lines held in memory count as abandoned too:
+
+```
+停止期限已到，放弃 30150 条未写出的记录
+```
+
+This record says the stop deadline was reached and 30150 unwritten records were abandoned.
+
+The deadline is checked between records only. A write already in progress, including an `fsync`, is not interrupted.
+The running total is in `LogStats::abandoned` and the metric `cslog_abandoned_total`.
+
+---
+
+# 32. Coroutine Front End (C++20)
+
+`#include "cslog/coro.h"` (requires C++20; the library itself still builds as C++17):
+
+```cpp
+// the callable that resumes the coroutine is required; usually it posts the handle back to your executor
+auto post = [&](std::coroutine_handle<> h) { asio::post(ioc, h); };
+
+// under the block policy, suspends the coroutine instead of blocking every coroutine on the executor thread
+co_await csLog::logAsync(csLog::LOG_LEVEL_INFO, "accepted " + peer, post);
+
+// like flush(), but suspends instead of waiting; the result means the same thing
+bool durable = co_await csLog::flushAsync(post);
+
+// a different logger goes last
+co_await csLog::logAsync(csLog::LOG_LEVEL_WARN, text, post, auditLogger);
+```
+
+* When the queue is full, `logAsync` hands the record to the logger and suspends the coroutine. Once the worker frees space, it enqueues parked records in arrival order and then calls `post(handle)`.
+  It never suspends under the `drop` / `warn` policies or when the queue has room.
+* There is no default, so user code never ends up on the logger's worker thread by accident. If you really want inline resumption, pass `csLog::ResumeOnLoggerThread{}` explicitly.
+
+> ⚠️ **With `ResumeOnLoggerThread`, everything the coroutine does after resuming, up to its next suspension, runs on the logger's worker thread.**
+> - No log records are written during that time.
+> - Logging from there does not wait for queue space, so the block policy has no effect and the queue can grow past its limit.
+> - `flush()` returns `false` immediately.
+>
+> Only use it for coroutines that finish, or switch threads, right after resuming.
+
+* When `stop(deadline)` expires, parked records are abandoned along with the queued ones, and their `co_await` returns `false`.
+* Any `flushAsync` still pending when the logger stops returns `false`.
+
+See `examples/coro/main.cpp` for a complete example.
+
+---
+
+# 33. fork() Safety (Prefork Servers)
+
+```yaml
+forkChildFile: false   # when true, children write {fileName}-{pid}_*.log
+```
+
+The logger handles `fork()` through `pthread_atfork`. No calls are needed around the fork:
+
+1. **Before the fork:** each instance's worker writes out its file and trace buffers and parks at a safe point. The forking thread holds the queue lock across the fork, so the child never inherits a half-written buffer or a locked queue.
+2. **Parent:** the lock is released and the worker carries on.
+3. **Child:**
+   - The condition variables are rebuilt.
+   - The queue and diagnostics inherited from the parent are discarded, since the parent writes them.
+   - The worker is restarted and writes one diagnostic record:
+
+```
+fork 后在子进程 10716 中重启后台线程
+```
+
+This record says the worker thread was restarted in child process 10716 after the fork.
+
+* `forkChildFile: false`: the child keeps using the inherited file. Each write is one `write` call of whole lines, so lines from different processes never interleave. Each process still rotates by its own counters.
+* `forkChildFile: true`: the child closes the inherited file, writes `{fileName}-{pid}_*.log` instead, and cleans up its own files by count and total size.
+* Trace files are always written per process. `LogStats` counters carry on from the parent's values.
+* An instance that was already `stop()`ped is not restarted in the child.
+* Windows has no `fork()`, so none of this applies there.
+
+---
+
 # ✅ Summary
 
 cslog offers a balanced combination of:
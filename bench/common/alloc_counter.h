@@ -0,0 +1,46 @@
+#ifndef CSLOG_BENCH_COMMON_ALLOC_COUNTER_H
+#define CSLOG_BENCH_COMMON_ALLOC_COUNTER_H
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+// 基准共用的堆分配计数：替换全局 operator new/delete，只统计当前线程在 allocCountBegin()/allocCountEnd() 之间的分配。
+// 替换函数不能声明为 inline，每个可执行文件只能有一个源文件包含本头文件。
+
+static thread_local bool   g_counting = false;
+static thread_local size_t g_allocs   = 0;
+static thread_local size_t g_bytes    = 0;
+
+void* operator new(std::size_t n)
+{
+    if (g_counting) {
+        ++g_allocs;
+        g_bytes += n;
+    }
+    if (void* p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+struct AllocCount {
+    size_t allocs;
+    size_t bytes;
+};
+
+static void allocCountBegin()
+{
+    g_allocs   = 0;
+    g_bytes    = 0;
+    g_counting = true;
+}
+
+static AllocCount allocCountEnd()
+{
+    g_counting = false;
+    return {g_allocs, g_bytes};
+}
+
+#endif // CSLOG_BENCH_COMMON_ALLOC_COUNTER_H
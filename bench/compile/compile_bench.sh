@@ -0,0 +1,27 @@
+#!/usr/bin/env bash
+# 测量包含 cslog 公共头的单个翻译单元的编译耗时。
+# 用法: compile_bench.sh <cxx> <cslog-include-dir> [iterations] [extra compiler flags...]
+set -euo pipefail
+
+CXX=$1
+INC=$2
+N=${3:-10}
+shift $(( $# >= 3 ? 3 : $# ))
+
+DIR=$(cd "$(dirname "$0")" && pwd)
+
+measure() {
+    local tu=$1; shift
+    local start end
+    start=$(date +%s%N)
+    for ((i = 0; i < N; ++i)); do
+        "$CXX" -std=c++17 -O2 -I"$INC" -I"$DIR" "$@" -c "$DIR/$tu" -o /dev/null
+    done
+    end=$(date +%s%N)
+    echo $(( (end - start) / N / 1000000 ))
+}
+
+slim=$(measure tu_slim.cpp "$@")
+legacy=$(measure tu_legacy.cpp "$@")
+
+echo "{\"iterations\":$N,\"tu_slim_ms\":$slim,\"tu_legacy_ms\":$legacy,\"saved_ms_per_tu\":$(( legacy - slim ))}"
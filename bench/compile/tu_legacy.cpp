@@ -0,0 +1,15 @@
+// 模拟拆分前的公共头：csLog.h 曾直接包含以下头文件
+#include <string>
+#include <sstream>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <queue>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+#include <yaml-cpp/yaml.h>
+
+#include "tu_slim.cpp"
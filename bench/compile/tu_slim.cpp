@@ -0,0 +1,9 @@
+#include "cslog/csLog.h"
+
+void compileBenchTu(int code, const char* name) {
+    LOG_INFO    << "service started: " << name;
+    LOG_DEBUG   << "debug value = " << code;
+    LOG_WARN    << "slow request, ms = " << code * 3;
+    LOG_ERROR_F << "request failed, code = " << code;
+    LOG_INFO_F  << "request done: " << name << " / " << code;
+}
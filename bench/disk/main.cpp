@@ -0,0 +1,180 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "cslog/csLog.h"
+#include "cslog/histogram.h"
+
+// 端到端写盘基准：按给定速率与记录大小经真实文件路径写入，滚动与总量清理处于开启状态。
+// 输出一个 JSON 对象：
+//   * 持续写盘 MB/s（含 stop() 排空）与实际记录速率
+//   * 后台线程 format / write / flush / rotate 耗时拆分（workerTiming）
+//   * 每 100ms 的最大队列深度
+//   * 生产者单次调用延迟分位，以及超过 stall_us 的停顿中与滚动重叠的次数
+// 用法: cslog_disk_bench [rate_per_sec(0=不限)] [record_bytes] [seconds] [threads]
+//                        [log_dir] [max_file_mb] [max_total_mb] [stall_us]
+
+using Clock = std::chrono::steady_clock;
+
+struct Stall {
+    int64_t startNs;
+    int64_t durNs;
+};
+
+struct Sample {
+    int64_t  tNs;
+    uint64_t depth;
+    uint64_t rotations;
+};
+
+static int64_t sinceNs(Clock::time_point origin)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - origin).count();
+}
+
+int main(int argc, char** argv)
+{
+    double      rate       = argc > 1 ? std::atof(argv[1]) : 0;
+    size_t      recordSize = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 200;
+    double      seconds    = argc > 3 ? std::atof(argv[3]) : 5;
+    int         threads    = argc > 4 ? std::atoi(argv[4]) : 4;
+    std::string logDir     = argc > 5 ? argv[5] : "./bench_logs/";
+    size_t      maxFileMb  = argc > 6 ? std::strtoull(argv[6], nullptr, 10) : 4;
+    size_t      maxTotalMb = argc > 7 ? std::strtoull(argv[7], nullptr, 10) : 32;
+    int64_t     stallNs    = (argc > 8 ? std::atoll(argv[8]) : 100) * 1000;
+
+    csLog::LogConfig cfg;
+    cfg.toConsole        = false;
+    cfg.toFile           = true;
+    cfg.logPath          = logDir;
+    cfg.baseName         = "cslog_disk_bench";
+    cfg.level            = csLog::LOG_LEVEL_INFO;
+    cfg.maxFileSize      = maxFileMb * 1024 * 1024;
+    cfg.maxLogsTotalSize = maxTotalMb * 1024 * 1024;
+    cfg.workerTiming     = true;
+
+    csLog::Logger logger(cfg);
+
+    const std::string payload(recordSize > 40 ? recordSize - 40 : 1, 'x');
+
+    std::vector<csLog::LatencyHistogram> hists(static_cast<size_t>(threads));
+    std::vector<std::vector<Stall>>      stalls(static_cast<size_t>(threads));
+    std::vector<Sample>                  samples;
+    std::atomic<bool>                    producing{true};
+
+    const auto origin   = Clock::now();
+    const auto deadline = origin + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+
+    std::thread sampler([&] {
+        while (producing.load(std::memory_order_relaxed)) {
+            csLog::LogStats st = logger.stats();
+            samples.push_back({sinceNs(origin), st.queueDepth, st.rotations});
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    });
+
+    std::vector<std::thread> producers;
+    for (int t = 0; t < threads; ++t) {
+        producers.emplace_back([&, t] {
+            auto&  hist     = hists[static_cast<size_t>(t)];
+            auto&  myStalls = stalls[static_cast<size_t>(t)];
+            double interval = rate > 0 ? double(threads) / rate : 0;
+            auto   next     = Clock::now();
+
+            for (uint64_t i = 0; Clock::now() < deadline; ++i) {
+                if (interval > 0) {
+                    next += std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(interval));
+                    std::this_thread::sleep_until(next);
+                }
+
+                int64_t t0 = sinceNs(origin);
+                LOG_INFO_TO(logger) << "seq=" << i << " thread=" << t << " " << payload;
+                int64_t d  = sinceNs(origin) - t0;
+
+                hist.record(static_cast<uint64_t>(d));
+                if (d >= stallNs) myStalls.push_back({t0, d});
+            }
+        });
+    }
+    for (auto& th : producers) th.join();
+    const double produceSec = std::chrono::duration<double>(Clock::now() - origin).count();
+
+    logger.stop();
+    const double totalSec = std::chrono::duration<double>(Clock::now() - origin).count();
+
+    producing.store(false, std::memory_order_relaxed);
+    sampler.join();
+
+    const csLog::LogStats st = logger.stats();
+
+    csLog::LatencyHistogram all;
+    for (const auto& h : hists) all.merge(h);
+
+    // 与任一发生了滚动的采样窗口重叠的停顿，视为滚动引起
+    uint64_t stallCount = 0, rotationStalls = 0;
+    int64_t  maxStall = 0, maxRotationStall = 0;
+    for (const auto& per : stalls) {
+        for (const Stall& s : per) {
+            ++stallCount;
+            maxStall = std::max(maxStall, s.durNs);
+
+            for (size_t k = 1; k < samples.size(); ++k) {
+                if (samples[k].rotations == samples[k - 1].rotations) continue;
+                if (s.startNs <= samples[k].tNs && s.startNs + s.durNs >= samples[k - 1].tNs) {
+                    ++rotationStalls;
+                    maxRotationStall = std::max(maxRotationStall, s.durNs);
+                    break;
+                }
+            }
+        }
+    }
+
+    const double mb = double(st.bytesWritten) / (1024.0 * 1024.0);
+    const double workerMs = double(st.formatNs + st.writeNs + st.flushNs + st.rotateNs) / 1e6;
+
+    std::printf("{\"rate_per_sec\":%.0f,\"record_bytes\":%zu,\"seconds\":%.1f,\"threads\":%d,"
+                "\"max_file_mb\":%zu,\"max_total_mb\":%zu,\n",
+                rate, recordSize, seconds, threads, maxFileMb, maxTotalMb);
+    std::printf(" \"enqueued\":%llu,\"dropped\":%llu,\"blocked\":%llu,\"written\":%llu,\"rotations\":%llu,\n",
+                static_cast<unsigned long long>(st.enqueued), static_cast<unsigned long long>(st.dropped),
+                static_cast<unsigned long long>(st.blocked), static_cast<unsigned long long>(st.written),
+                static_cast<unsigned long long>(st.rotations));
+    std::printf(" \"mb_written\":%.2f,\"mb_per_sec\":%.2f,\"records_per_sec\":%.0f,\"produce_sec\":%.3f,\"total_sec\":%.3f,\n",
+                mb, mb / totalSec, double(st.written) / totalSec, produceSec, totalSec);
+    std::printf(" \"worker_ms\":{\"format\":%.1f,\"write\":%.1f,\"flush\":%.1f,\"rotate\":%.1f,\"total\":%.1f},\n",
+                double(st.formatNs) / 1e6, double(st.writeNs) / 1e6,
+                double(st.flushNs) / 1e6, double(st.rotateNs) / 1e6, workerMs);
+    std::printf(" \"producer_ns\":{\"p50\":%llu,\"p99\":%llu,\"p999\":%llu,\"max\":%llu},\n",
+                static_cast<unsigned long long>(all.percentile(0.50)),
+                static_cast<unsigned long long>(all.percentile(0.99)),
+                static_cast<unsigned long long>(all.percentile(0.999)),
+                static_cast<unsigned long long>(all.max()));
+    std::printf(" \"stalls\":{\"threshold_us\":%lld,\"count\":%llu,\"during_rotation\":%llu,"
+                "\"max_us\":%.1f,\"max_during_rotation_us\":%.1f},\n",
+                static_cast<long long>(stallNs / 1000),
+                static_cast<unsigned long long>(stallCount), static_cast<unsigned long long>(rotationStalls),
+                double(maxStall) / 1e3, double(maxRotationStall) / 1e3);
+
+    // 每 100ms 取窗口内的最大深度：[毫秒, 深度]
+    std::printf(" \"queue_depth\":[");
+    uint64_t windowMax = 0;
+    int64_t  windowEnd = 100 * 1000000LL;
+    bool     firstPoint = true;
+    for (const Sample& s : samples) {
+        while (s.tNs >= windowEnd) {
+            std::printf("%s[%lld,%llu]", firstPoint ? "" : ",",
+                        static_cast<long long>(windowEnd / 1000000), static_cast<unsigned long long>(windowMax));
+            firstPoint = false;
+            windowMax  = 0;
+            windowEnd += 100 * 1000000LL;
+        }
+        windowMax = std::max(windowMax, s.depth);
+    }
+    std::printf("]}\n");
+    return 0;
+}
@@ -0,0 +1,27 @@
+#!/usr/bin/env bash
+# 统计各内核热路径的机器码大小（不含编译器拆出的 .cold 片段），
+# 以及冷路径被移入 .text.unlikely 的字节数。
+# 用法: codesize.sh <cxx> <cslog-include-dir> [extra compiler flags...]
+set -euo pipefail
+
+CXX=$1
+INC=$2
+shift 2
+
+DIR=$(cd "$(dirname "$0")" && pwd)
+OBJ=$(mktemp --suffix=.o)
+trap 'rm -f "$OBJ"' EXIT
+
+"$CXX" -std=c++17 -O2 -I"$INC" "$@" -c "$DIR/kernels.cpp" -o "$OBJ"
+
+symsize() {
+    local hex
+    hex=$(nm -S -C "$OBJ" | grep " $1(" | grep -v "\.cold" | awk '{ print $2 }' | head -n1)
+    echo $(( 16#${hex:-0} ))
+}
+
+secsize() {
+    size -A "$OBJ" | awk -v sec="$1" '$1 == sec { s += $2 } END { print s + 0 }'
+}
+
+echo "{\"plain_bytes\":$(symsize kernelPlain),\"macro_bytes\":$(symsize kernelMacro),\"inline_bytes\":$(symsize kernelInline),\"debug_gate_bytes\":$(symsize kernelDebugGate),\"text_bytes\":$(secsize .text),\"text_unlikely_bytes\":$(secsize .text.unlikely)}"
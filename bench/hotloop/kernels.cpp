@@ -0,0 +1,68 @@
+#include "kernels.h"
+
+#include <sstream>
+#include "cslog/csLog.h"
+
+static inline uint64_t mix(uint64_t h, uint32_t v)
+{
+    h ^= v;
+    h *= 0x9E3779B97F4A7C15ull;
+    return h ^ (h >> 29);
+}
+
+uint64_t kernelPlain(const uint32_t* data, size_t n, uint32_t sentinel)
+{
+    uint64_t h = 0;
+    for (size_t i = 0; i < n; ++i) {
+        if (data[i] == sentinel) {
+            h = 0;
+        }
+        h = mix(h, data[i]);
+    }
+    return h;
+}
+
+// 当前宏：调用点只有等级比较与冷函数调用
+uint64_t kernelMacro(const uint32_t* data, size_t n, uint32_t sentinel)
+{
+    uint64_t h = 0;
+    for (size_t i = 0; i < n; ++i) {
+        if (data[i] == sentinel) {
+            LOG_WARN_F << "sentinel hit i=" << i << " h=" << h;
+            h = 0;
+        }
+        h = mix(h, data[i]);
+    }
+    return h;
+}
+
+// 对照组：日志语句在调用点完整展开（ostringstream 构造 / 析构、取字符串、入队），
+// 与拆分前内联 LogLine 的代码形态相当
+uint64_t kernelInline(const uint32_t* data, size_t n, uint32_t sentinel)
+{
+    uint64_t h = 0;
+    for (size_t i = 0; i < n; ++i) {
+        if (data[i] == sentinel) {
+            std::ostringstream ss;
+            ss << "sentinel hit i=" << i << " h=" << h;
+            csLog::Logger::instance().push(csLog::LOG_LEVEL_WARN, ss.str());
+            h = 0;
+        }
+        h = mix(h, data[i]);
+    }
+    return h;
+}
+
+// 每次迭代都经过一条被等级过滤掉的 DEBUG 语句，衡量门限本身的开销
+uint64_t kernelDebugGate(const uint32_t* data, size_t n, uint32_t sentinel)
+{
+    uint64_t h = 0;
+    for (size_t i = 0; i < n; ++i) {
+        LOG_DEBUG << "i=" << i << " v=" << data[i];
+        if (data[i] == sentinel) {
+            h = 0;
+        }
+        h = mix(h, data[i]);
+    }
+    return h;
+}
@@ -0,0 +1,14 @@
+#ifndef CSLOG_BENCH_HOTLOOP_KERNELS_H
+#define CSLOG_BENCH_HOTLOOP_KERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+
+// 四个内核计算相同，区别只在循环体内的日志语句。
+// sentinel 不会出现在数据中，带日志的分支在运行期从不进入，只影响代码布局。
+uint64_t kernelPlain(const uint32_t* data, size_t n, uint32_t sentinel);
+uint64_t kernelMacro(const uint32_t* data, size_t n, uint32_t sentinel);
+uint64_t kernelInline(const uint32_t* data, size_t n, uint32_t sentinel);
+uint64_t kernelDebugGate(const uint32_t* data, size_t n, uint32_t sentinel);
+
+#endif // CSLOG_BENCH_HOTLOOP_KERNELS_H
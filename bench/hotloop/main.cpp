@@ -0,0 +1,54 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "cslog/csLog.h"
+#include "kernels.h"
+
+// 紧循环内放置日志语句对运行时间的影响（ns/元素），结果以 JSON 输出。
+// 用法: cslog_hotloop_bench [elements] [rounds]
+int main(int argc, char** argv)
+{
+    size_t n      = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1 << 16;
+    int    rounds = argc > 2 ? std::atoi(argv[2]) : 2000;
+
+    csLog::LogConfig cfg;
+    cfg.toConsole = false;
+    cfg.toFile    = false;
+    cfg.level     = csLog::LOG_LEVEL_INFO;
+    csLog::init(cfg);
+
+    std::vector<uint32_t> data(n);
+    std::mt19937 rng(42);
+    for (auto& v : data) v = rng() & 0x7FFFFFFF;
+    const uint32_t sentinel = 0xFFFFFFFF;
+
+    struct Kernel {
+        const char* name;
+        uint64_t (*fn)(const uint32_t*, size_t, uint32_t);
+    } kernels[] = {
+        {"plain",      kernelPlain},
+        {"macro",      kernelMacro},
+        {"inline",     kernelInline},
+        {"debug_gate", kernelDebugGate},
+    };
+
+    uint64_t sink = 0;
+    std::printf("{\"elements\":%zu,\"rounds\":%d", n, rounds);
+    for (const Kernel& k : kernels) {
+        sink += k.fn(data.data(), n, sentinel);
+
+        auto start = std::chrono::steady_clock::now();
+        for (int r = 0; r < rounds; ++r) {
+            sink += k.fn(data.data(), n, sentinel);
+        }
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count();
+
+        std::printf(",\"%s_ns_per_elem\":%.3f", k.name, double(ns) / double(n) / rounds);
+    }
+    std::printf(",\"checksum\":%llu}\n", static_cast<unsigned long long>(sink & 0xFFFF));
+    return 0;
+}
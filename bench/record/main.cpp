@@ -0,0 +1,83 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "cslog/csLog.h"
+#include "../common/alloc_counter.h"
+
+// LogTask 内联正文的内存与延迟基准，结果以 JSON 输出。
+// 分别以短正文（落在内联存储内）与长正文（转存到堆上）测量：
+//   * 生产者线程上每条记录的分配次数与字节数
+//   * 单条 LOG_INFO 的调用耗时分位数与最大值（含一次 steady_clock 读取的开销）
+//   * 调大 maxQueueSize 时一次性备好环形数组存储的耗时，单独列出，不摊进每条记录
+// 用法: cslog_record_bench [records]
+
+struct Result {
+    double allocs;
+    double bytes;
+    long long p50;
+    long long p99;
+    long long p999;
+    long long max;
+};
+
+static Result run(int records, const std::string& payload)
+{
+    std::vector<long long> samples(static_cast<size_t>(records));
+
+    allocCountBegin();
+    for (int i = 0; i < records; ++i) {
+        auto t0 = std::chrono::steady_clock::now();
+        LOG_INFO << "order id=" << i << " note=" << payload;
+        auto t1 = std::chrono::steady_clock::now();
+        samples[static_cast<size_t>(i)] = std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count();
+    }
+    AllocCount c = allocCountEnd();
+
+    std::sort(samples.begin(), samples.end());
+    auto at = [&](double q) { return samples[static_cast<size_t>(q * (samples.size() - 1))]; };
+
+    return {double(c.allocs) / records, double(c.bytes) / records, at(0.50), at(0.99), at(0.999), samples.back()};
+}
+
+int main(int argc, char** argv)
+{
+    int records = argc > 1 ? std::atoi(argv[1]) : 200000;
+
+    csLog::LogConfig cfg;
+    cfg.toConsole = false;
+    cfg.toFile    = false;
+    csLog::init(cfg);
+
+    // 存储在锁外分配与构造，生产者之后入队不再扩容；这一步的代价在这里单独计时
+    const size_t ringSlots = static_cast<size_t>(records) + 1000;
+    auto r0 = std::chrono::steady_clock::now();
+    csLog::Logger::instance().setMaxQueueSize(ringSlots);
+    auto r1 = std::chrono::steady_clock::now();
+    const long long reserveNs = std::chrono::duration_cast<std::chrono::nanoseconds>(r1 - r0).count();
+
+    for (int i = 0; i < 1000; ++i) LOG_INFO << "warmup " << i;
+
+    const std::string shortPayload(100, 's');
+    const std::string longPayload(600, 'l');
+
+    Result s = run(records, shortPayload);
+    Result l = run(records, longPayload);
+
+    csLog::Logger::instance().stop();
+
+    std::printf("{\"records\":%d,\"sizeof_log_task\":%zu,\"inline_capacity\":%zu,"
+                "\"ring_slots\":%zu,\"ring_bytes\":%zu,\"ring_reserve_ns\":%lld,"
+                "\"short_allocs_per_record\":%.3f,\"short_bytes_per_record\":%.1f,"
+                "\"short_p50_ns\":%lld,\"short_p99_ns\":%lld,\"short_p999_ns\":%lld,\"short_max_ns\":%lld,"
+                "\"long_allocs_per_record\":%.3f,\"long_bytes_per_record\":%.1f,"
+                "\"long_p50_ns\":%lld,\"long_p99_ns\":%lld,\"long_p999_ns\":%lld,\"long_max_ns\":%lld}\n",
+                records, sizeof(csLog::LogTask), csLog::LogText::INLINE_CAPACITY,
+                ringSlots, ringSlots * sizeof(csLog::LogTask), reserveNs,
+                s.allocs, s.bytes, s.p50, s.p99, s.p999, s.max,
+                l.allocs, l.bytes, l.p50, l.p99, l.p999, l.max);
+    return 0;
+}
@@ -1,6 +1,7 @@
 #include "cslog/csLog.h"
 #include <thread>
 #include <chrono>
+#include <string>
 
 int main() {
     LOG_INFO << "cslog example started";
@@ -8,6 +9,11 @@ int main() {
     LOG_WARN  << "This is a warning";
     LOG_ERROR_F << "This is an error with file/line/func info";
 
+    // 多个捕获的 lambda 可直接作为宏参数
+    int requestId = 42;
+    std::string user = "alice";
+    LOG_DEBUG_LAZY([requestId, &user] { return "request " + std::to_string(requestId) + " from " + user; });
+
     for (int i = 0; i < 10; ++i) {
         LOG_INFO_F << "loop index = " << i;
         std::this_thread::sleep_for(std::chrono::milliseconds(100));
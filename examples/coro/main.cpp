@@ -0,0 +1,72 @@
+#include "cslog/coro.h"
+#include <condition_variable>
+#include <coroutine>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <string>
+
+// 最小的即发即忘协程类型，实际项目中换成所用框架的 task
+struct Detached {
+    struct promise_type {
+        Detached get_return_object() { return {}; }
+        std::suspend_never initial_suspend() { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+// 最小的单线程执行器：日志后台线程只负责投递句柄，协程在 run() 所在的线程上恢复
+class Executor {
+public:
+    void post(std::coroutine_handle<> h)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            ready.push_back(h);
+        }
+        cv.notify_one();
+    }
+
+    void run(const bool& finished)
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        while (!finished) {
+            cv.wait(lock, [&] { return !ready.empty(); });
+            std::coroutine_handle<> h = ready.front();
+            ready.pop_front();
+
+            lock.unlock();
+            h.resume();
+            lock.lock();
+        }
+    }
+
+private:
+    std::mutex                          mtx;
+    std::condition_variable             cv;
+    std::deque<std::coroutine_handle<>> ready;
+};
+
+Detached session(Executor& ex, int id, bool& finished) {
+    auto post = [&ex](std::coroutine_handle<> h) { ex.post(h); };
+
+    for (int i = 0; i < 1000; ++i) {
+        // block 策略下队列满时挂起协程，不阻塞当前线程
+        co_await csLog::logAsync(csLog::LOG_LEVEL_INFO, "session " + std::to_string(id) + " seq = " + std::to_string(i), post);
+    }
+
+    bool durable = co_await csLog::flushAsync(post);
+    LOG_INFO << "session " << id << " flushed, durable = " << durable;
+    finished = true;
+}
+
+int main() {
+    Executor ex;
+    bool     finished = false;
+
+    session(ex, 1, finished);
+    ex.run(finished);
+    return 0;
+}
@@ -0,0 +1,23 @@
+#include "cslog/static_logger.h"
+#include <filesystem>
+
+using FeedLogger = csLog::StaticLogger<csLog::FileSink<csLog::JsonLayout>,
+                                       csLog::ConsoleSink<csLog::TextLayout>>;
+
+int main() {
+    std::filesystem::create_directories("./logs/");
+
+    FeedLogger feedLog({csLog::LOG_LEVEL_INFO},
+                       csLog::FileSink<csLog::JsonLayout>("./logs/feed.log"),
+                       csLog::ConsoleSink<csLog::TextLayout>());
+
+    SLOG_INFO(feedLog) << "static logger started";
+    SLOG_DEBUG(feedLog) << "filtered out by level";
+
+    for (int i = 0; i < 5; ++i) {
+        SLOG_INFO_F(feedLog) << "tick seq = " << i;
+    }
+
+    SLOG_WARN(feedLog) << "static logger finished";
+    return 0;
+}
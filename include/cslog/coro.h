@@ -0,0 +1,132 @@
+#ifndef CSLOG_CORO_H
+#define CSLOG_CORO_H
+
+#if !(__cplusplus >= 202002L || (defined(_MSVC_LANG) && _MSVC_LANG >= 202002L))
+#error "cslog/coro.h 需要 C++20 协程支持"
+#endif
+
+#include <coroutine>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include "csLog.h"
+
+// C++20 协程前端：队列已满（block 策略）或等待刷新时挂起协程，而不是阻塞所在的执行线程。
+//
+// 挂起后由日志后台线程调用 resume(handle) 恢复协程，resume 必须显式传入，通常把句柄投递回自己的执行器：
+//
+//   auto post = [&](std::coroutine_handle<> h) { asio::post(ioc, h); };
+//   bool ok      = co_await csLog::logAsync(csLog::LOG_LEVEL_INFO, "accepted " + peer, post);
+//   bool durable = co_await csLog::flushAsync(post);
+//
+// csLog::ResumeOnLoggerThread 直接在【日志后台线程】上恢复，直到下一次挂起之前的用户代码都跑在后台线程上——
+// 期间所有日志停止写出；在那里写日志不会等待队列空位（block 策略失效，队列可超过上限），
+// 调用 Logger::flush() 只会返回 false。只适合恢复后立即结束或自行切换线程的协程。
+
+namespace csLog {
+
+// 在后台线程上直接恢复，需要显式选用，见文件头的说明
+struct ResumeOnLoggerThread {
+    void operator()(std::coroutine_handle<> h) const { h.resume(); }
+};
+
+template <class Resume>
+class LogAwaitable {
+    static_assert(std::is_invocable_v<Resume&, std::coroutine_handle<>>,
+                  "resume 须可以 coroutine_handle<> 调用，例如把句柄投递到执行器的可调用对象");
+
+public:
+    LogAwaitable(Logger& logger, LogTask&& task, Resume resume)
+        : logger(logger), task(std::move(task)), resume(std::move(resume)) {}
+
+    // 等级被过滤时不挂起
+    bool await_ready() const noexcept { return !logger.enabled(task.lvl); }
+
+    bool await_suspend(std::coroutine_handle<> h)
+    {
+        handle = h;
+        // 返回 false 后回调随时可能在后台线程上恢复协程并销毁本对象，之后不再访问成员
+        return !logger.pushAsync(std::move(task), &LogAwaitable::done, this);
+    }
+
+    // false 表示 stop(deadline) 到期时记录被放弃
+    bool await_resume() const noexcept { return ok; }
+
+private:
+    static void done(void* arg, bool ok)
+    {
+        auto* self = static_cast<LogAwaitable*>(arg);
+        self->ok   = ok;
+
+        // 恢复后本对象可能随协程帧一起销毁，先取出所需成员
+        Resume r = std::move(self->resume);
+        r(self->handle);
+    }
+
+    Logger&                 logger;
+    LogTask                 task;
+    Resume                  resume;
+    std::coroutine_handle<> handle;
+    bool                    ok = true;
+};
+
+template <class Resume>
+class FlushAwaitable {
+    static_assert(std::is_invocable_v<Resume&, std::coroutine_handle<>>,
+                  "resume 须可以 coroutine_handle<> 调用，例如把句柄投递到执行器的可调用对象");
+
+public:
+    FlushAwaitable(Logger& logger, Resume resume)
+        : logger(logger), resume(std::move(resume)) {}
+
+    bool await_ready() const noexcept { return false; }
+
+    bool await_suspend(std::coroutine_handle<> h)
+    {
+        handle = h;
+        if (!logger.flushAsync(&FlushAwaitable::done, this)) {
+            ok = false;
+            return false;
+        }
+        return true;
+    }
+
+    // 含义同 Logger::flush()：调用前入队的记录已写入并 fsync 且未处于降级模式
+    bool await_resume() const noexcept { return ok; }
+
+private:
+    static void done(void* arg, bool ok)
+    {
+        auto* self = static_cast<FlushAwaitable*>(arg);
+        self->ok   = ok;
+
+        Resume r = std::move(self->resume);
+        r(self->handle);
+    }
+
+    Logger&                 logger;
+    Resume                  resume;
+    std::coroutine_handle<> handle;
+    bool                    ok = false;
+};
+
+template <class Resume>
+LogAwaitable<Resume> logAsync(LogLevel lvl, std::string text, Resume resume,
+                              Logger& logger = Logger::instance())
+{
+    LogTask task;
+    task.lvl   = lvl;
+    task.text  = std::move(text);
+    task.ticks = logger.now(task.clockMode);
+    return LogAwaitable<Resume>(logger, std::move(task), std::move(resume));
+}
+
+template <class Resume>
+FlushAwaitable<Resume> flushAsync(Resume resume, Logger& logger = Logger::instance())
+{
+    return FlushAwaitable<Resume>(logger, std::move(resume));
+}
+
+} // namespace csLog
+
+#endif // CSLOG_CORO_H
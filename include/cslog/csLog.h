@@ -2,20 +2,32 @@
 #define CSLOG_H
 
 #include <string>
-#include <sstream>
-#include <fstream>
-#include <mutex>
-#include <thread>
-#include <condition_variable>
-#include <queue>
+#include <string_view>
+#include <ostream>
+#include <streambuf>
+#include <atomic>
 #include <chrono>
-#include <iomanip>
-#include <iostream>
-#include <vector>
-#include <yaml-cpp/yaml.h>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <utility>
 #include "version.h"
 
+#ifndef CSLOG_CONFIG_PATH
 #define CSLOG_CONFIG_PATH "../config/config.yaml"
+#endif
+
+// 日志语句的构造 / 析构放在冷路径上，循环体内只剩等级比较与一条分支；LogLine 的栈空间仍由所在函数预留
+#if defined(__GNUC__) || defined(__clang__)
+#define CSLOG_COLD          __attribute__((cold, noinline))
+#define CSLOG_UNLIKELY(x)   __builtin_expect(!!(x), 0)
+#elif defined(_MSC_VER)
+#define CSLOG_COLD          __declspec(noinline)
+#define CSLOG_UNLIKELY(x)   (x)
+#else
+#define CSLOG_COLD
+#define CSLOG_UNLIKELY(x)   (x)
+#endif
 
 namespace csLog {
 
@@ -49,6 +61,12 @@ inline const char* levelColor(LogLevel lvl) {
 
 static constexpr const char* COLOR_RESET = "\033[0m";
 
+// 单个等级的令牌桶：每秒补充 perSec 个，最多积累 burst 个（0 时取 perSec）；perSec 为 0 表示不限
+struct LevelRateLimit {
+    int perSec = 0;
+    int burst  = 0;
+};
+
 struct LogConfig {
     bool enable     = true;
     bool toConsole  = true;
@@ -65,79 +83,538 @@ struct LogConfig {
 
     size_t      maxQueueSize = 20000;
     std::string queuePolicy  = "block";
+
+    bool        toTrace      = false;
+
+    // 每条记录携带入队序号（含被丢弃的记录），下游可据序号缺口发现丢失
+    bool        sequence     = false;
+
+    std::string clock        = "system";
+
+    std::string consoleFormat = "json";
+    std::string fileFormat    = "json";
+
+    std::string durability    = "batch";
+
+    // 磁盘写满或 I/O 出错时转入降级模式，已格式化的记录暂存在内存中（超出上限丢弃最旧的），
+    // 退避重试恢复后补写
+    size_t      degradedBufferSize = 8 * 1024 * 1024;
+
+    // fork() 后子进程重启后台线程并改写 {baseName}-{pid}_*.log，不与父进程共用文件；
+    // 关闭时子进程沿用继承的文件，与父进程各自按整行追加
+    bool        forkChildFile = false;
+
+    bool        workerTiming  = false;
+
+    // 每个线程每 latencySampleEvery 条 LogLine 采样一条的各段耗时，0 为关闭；
+    // 每 latencyReportSec 秒汇总为一条 INFO 记录输出
+    int         latencySampleEvery = 0;
+    int         latencyReportSec   = 60;
+
+    // 以 Prometheus 文本格式定期写出自身指标，供 node exporter 的 textfile collector 采集；空为关闭
+    std::string metricsFile        = "";
+    int         metricsIntervalSec = 10;
+
+    // 每 callsiteReportSec 秒按调用点（file:line）汇总记录数与字节数，
+    // 输出前 callsiteTopN 个为一条 INFO 记录；0 为关闭
+    int         callsiteReportSec  = 0;
+    int         callsiteTopN       = 10;
+
+    // 单个调用点每秒记录数上限，超过后该调用点改为每 N 条输出一条，速率回落到一半以下时恢复；0 为关闭
+    int         callsiteRateLimit  = 0;
+
+    // 按等级限速（下标为 LogLevel），在生产者侧格式化之前检查，超出的记录直接丢弃并计数；
+    // 有丢弃时每 rateLimitReportSec 秒输出一条汇总
+    LevelRateLimit levelRateLimit[4];
+    int            rateLimitReportSec = 10;
+};
+
+// 运行统计快照，见 Logger::stats()。
+// format / write / rotate 耗时只在 workerTiming 开启时累计，rotateNs 包含滚动时的 flush / 清理 / 建新文件；
+// flush 次数与耗时始终统计。
+struct LogStats {
+    uint64_t enqueued      = 0;
+    uint64_t dropped       = 0;
+    uint64_t rateLimited[4] = {};  // 按等级限速丢弃的条数，下标同 writtenByLevel
+    uint64_t blocked       = 0;  // block 策略下因队列满等待过的入队次数
+    uint64_t blockedNs     = 0;
+    uint64_t written       = 0;
+    uint64_t writtenByLevel[4] = {};  // 按 LogLevel 下标：ERROR / WARN / INFO / DEBUG
+    uint64_t flushes       = 0;
+    uint64_t bytesWritten  = 0;
+    uint64_t rotations     = 0;
+    uint64_t queueDepth    = 0;
+    uint64_t maxQueueDepth = 0;
+
+    uint64_t formatNs = 0;
+    uint64_t writeNs  = 0;
+    uint64_t flushNs  = 0;
+    uint64_t rotateNs = 0;
+
+    uint64_t ioErrors         = 0;  // 打开 / 写入 / flush 失败次数
+    uint64_t degradedEntries  = 0;  // 进入降级模式的次数
+    uint64_t degradedDropped  = 0;  // 降级期间因内存缓冲满丢弃的最旧记录条数
+    uint64_t degradedBuffered = 0;  // 当前暂存在内存中的字节数
+    uint64_t emergencyDeletes = 0;  // 磁盘写满时紧急删除的旧日志文件数
+    bool     degraded         = false;
+
+    uint64_t abandoned        = 0;  // stop(deadline) 到期时放弃的记录数
 };
 
 LogConfig& config();
 
+// 显式初始化默认实例：在第一条日志之前完成配置与线程启动。
+// 默认实例已存在时返回 false。未调用时，首条日志按 CSLOG_CONFIG 环境变量 /
+// CSLOG_CONFIG_PATH 在后台线程中加载配置，文件不存在则使用内置默认值。
+bool init(const LogConfig& config);
+bool initFromFile(const std::string& path);
+
+// 日志正文：不超过 INLINE_CAPACITY 字节时存放在对象内部，入队只是一次 memcpy，不经过分配器；
+// 更长的正文转存到堆上的 std::string，移动时直接转移所有权。
+class LogText {
+public:
+    static constexpr size_t INLINE_CAPACITY = 256;
+
+    LogText() = default;
+    LogText(const LogText& o) { assign(o.view()); }
+    LogText(LogText&& o) noexcept { moveFrom(o); }
+
+    LogText& operator=(const LogText& o)
+    {
+        if (this != &o) assign(o.view());
+        return *this;
+    }
+
+    LogText& operator=(LogText&& o) noexcept
+    {
+        if (this != &o) moveFrom(o);
+        return *this;
+    }
+
+    LogText& operator=(std::string_view s) { assign(s); return *this; }
+
+    // 长正文直接接管 std::string 的缓冲区
+    LogText& operator=(std::string&& s)
+    {
+        if (s.size() <= INLINE_CAPACITY) {
+            assign(s);
+        } else {
+            len    = s.size();
+            heap   = std::move(s);
+            onHeap = true;
+        }
+        return *this;
+    }
+
+    const char* data() const     { return onHeap ? heap.data() : inlineBuf; }
+    char*       data()           { return onHeap ? &heap[0] : inlineBuf; }
+    size_t      size() const     { return len; }
+    size_t      capacity() const { return onHeap ? heap.size() : INLINE_CAPACITY; }
+    bool        empty() const    { return len == 0; }
+    bool        inlined() const  { return !onHeap; }
+    char        back() const     { return data()[len - 1]; }
+    void        pop_back()       { --len; }
+    void        clear()          { len = 0; }
+
+    std::string_view view() const { return std::string_view(data(), len); }
+    operator std::string_view() const { return view(); }
+
+    void assign(std::string_view s)
+    {
+        len = 0;
+        reserve(s.size());
+        std::char_traits<char>::copy(data(), s.data(), s.size());
+        len = s.size();
+    }
+
+    // 保证容量至少为 n，已有内容保留
+    void reserve(size_t n)
+    {
+        if (n <= capacity()) return;
+
+        size_t cap = capacity() * 2;
+        if (cap < n) cap = n;
+
+        if (onHeap) {
+            heap.resize(cap);
+        } else {
+            std::string grown(cap, '\0');
+            std::char_traits<char>::copy(&grown[0], inlineBuf, len);
+            heap   = std::move(grown);
+            onHeap = true;
+        }
+    }
+
+    // 直接写入 data() 之后设置有效长度，n 不超过 capacity()
+    void setSize(size_t n) { len = n; }
+
+private:
+    void moveFrom(LogText& o)
+    {
+        len = o.len;
+        if (o.onHeap) {
+            heap   = std::move(o.heap);
+            onHeap = true;
+        } else {
+            std::char_traits<char>::copy(inlineBuf, o.inlineBuf, o.len);
+            onHeap = false;
+        }
+        o.len    = 0;
+        o.onHeap = false;
+    }
+
+    size_t      len    = 0;
+    bool        onHeap = false;
+    std::string heap;
+    char        inlineBuf[INLINE_CAPACITY];
+};
+
+// 让 << 的输出直接写入 LogText 的存储，结束时 finish() 设置长度，
+// 短正文全程不分配内存，也没有 ostringstream::str() 的整段拷贝
+class LogStreamBuf : public std::streambuf {
+public:
+    explicit LogStreamBuf(LogText& out) : out(out)
+    {
+        out.clear();
+        setp(out.data(), out.data() + out.capacity());
+    }
+
+    void finish() { out.setSize(static_cast<size_t>(pptr() - pbase())); }
+
+protected:
+    int_type overflow(int_type ch) override
+    {
+        if (traits_type::eq_int_type(ch, traits_type::eof())) return traits_type::not_eof(ch);
+
+        grow(1);
+        *pptr() = traits_type::to_char_type(ch);
+        pbump(1);
+        return ch;
+    }
+
+    std::streamsize xsputn(const char* s, std::streamsize n) override
+    {
+        if (epptr() - pptr() < n) grow(static_cast<size_t>(n));
+
+        traits_type::copy(pptr(), s, static_cast<size_t>(n));
+        pbump(static_cast<int>(n));
+        return n;
+    }
+
+private:
+    void grow(size_t need)
+    {
+        size_t used = static_cast<size_t>(pptr() - pbase());
+        out.setSize(used);
+        out.reserve(used + need);
+        setp(out.data(), out.data() + out.capacity());
+        pbump(static_cast<int>(used));
+    }
+
+    LogText& out;
+};
+
+// 调用 fn 并把结果写入 out：按值返回的 std::string 直接接管，能转成 string_view 的按长度拷贝，其余经 ostream 输出
+template <class F>
+void renderLazyText(LogText& out, F& fn)
+{
+    using R = decltype(fn());
+    if constexpr (std::is_same_v<R, std::string>) {
+        out = fn();
+    } else if constexpr (std::is_convertible_v<R, std::string_view>) {
+        out = std::string_view(fn());
+    } else if constexpr (std::is_convertible_v<R, std::string>) {
+        out = std::string(fn());
+    } else {
+        LogStreamBuf sb(out);
+        std::ostream os(&sb);
+        os << fn();
+        sb.finish();
+    }
+}
+
+// 同步 _LAZY 在调用线程上渲染，可调用对象留在调用方栈上，经函数指针访问，不做堆分配
+using LazyRender = void (*)(LogText& out, void* fn);
+
+template <class F>
+void renderLazyThunk(LogText& out, void* fn)
+{
+    renderLazyText(out, *static_cast<F*>(fn));
+}
+
+// 延迟生成的日志正文：只有确定要输出这条记录时才调用 render()；_ASYNC 版本带到后台线程上执行
+struct LazyText {
+    virtual ~LazyText() = default;
+    virtual void render(LogText& out) = 0;
+};
+
+template <class F>
+struct LazyTextFn final : LazyText {
+    explicit LazyTextFn(F f) : fn(std::move(f)) {}
+
+    void render(LogText& out) override { renderLazyText(out, fn); }
+
+    F fn;
+};
+
+class LatencyHistogram;
+
+// 日志语句的调用点，由 CSLOG_CALLSITE() 在每条语句处生成一个常量初始化的静态对象，
+// 以地址区分调用点，后台线程据此统计各语句产生的记录数与字节数。
+// sampleEvery 由后台线程按 callsiteRateLimit 设置，大于 1 时该调用点每 sampleEvery 条只输出一条。
+struct CallSite {
+    const char* file;
+    int         line;
+
+    mutable std::atomic<uint32_t> sampleEvery{0};
+    mutable std::atomic<uint32_t> sampleSeq{0};
+};
+
+// 后台线程剖析的阶段（需以 CSLOG_PROFILE_WORKER 编译 csLog.cpp）。
+// Rotate 包含其中的 Flush / Cleanup / CreateFile。
+enum class WorkerStage : uint8_t {
+    Dequeue,
+    Console,
+    FileBuffer,   // 每条记录追加到文件缓冲
+    FileWrite,    // 缓冲写出到文件的 fwrite + fflush
+    Flush,
+    Rotate,
+    CreateFile,
+    Cleanup,
+    Count
+};
+
+const char* workerStageName(WorkerStage stage);
+
+enum class TaskKind : uint8_t {
+    Record,
+    Span,
+    Gap     // 队列满丢弃后由入队侧插入的缺口标记，见 LogTask::dropped
+};
+
+// ticks 为生产者读取的原始时钟值（见 config().clock），clockMode 为读取时的时钟来源，
+// 由后台线程换算为墙上时间。endTicks 对 Span 为结束时刻，对 Gap 为第一次丢弃的时刻。
 struct LogTask {
-    LogLevel    lvl;
-    std::string text;
+    LogLevel    lvl  = LOG_LEVEL_INFO;
+    LogText     text;
+
+    TaskKind    kind      = TaskKind::Record;
+    uint8_t     clockMode = 0;
+    uint64_t    ticks    = 0;
+    uint64_t    endTicks = 0;
+    uint64_t    tid      = 0;
+    uint64_t    seq      = 0;  // 入队序号，未开启 sequence 时为 0
+    uint64_t    dropped  = 0;  // Gap：自 endTicks 起丢弃的条数
+
+    const char* file     = nullptr;
+    int         line     = 0;
+    const char* func     = nullptr;
+    const char* spanName = nullptr;
+
+    const CallSite* site = nullptr;
+
+    std::unique_ptr<LazyText> lazy;
 };
 
+// 每个 Logger 拥有独立的配置、队列、后台线程与文件集合。
+// instance() 为默认实例（从 CSLOG_CONFIG_PATH 加载配置）；其他实例可直接由 LogConfig 构造。
+// 队列、线程与文件等实现细节在 csLog.cpp 的 Logger::Impl 中，本头文件只暴露前端。
 class Logger {
 public:
     static Logger& instance();
-    void push(LogLevel lvl, const std::string& msg);
-    void stop();
 
-private:
-    Logger();
+    explicit Logger(const LogConfig& config);
     ~Logger();
 
-    void loadConfigFromFile();
+    Logger(const Logger&)            = delete;
+    Logger& operator=(const Logger&) = delete;
+
+    // 直接修改返回的配置只适合在首条日志之前进行；默认实例延迟加载配置文件时，
+    // 文件只覆盖其中出现的项，其余保留修改后的值
+    LogConfig& config();
+    uint64_t   now(uint8_t& clockMode) const;
+
+    // 运行时调整等级与队列上限，同时刷新生产者侧的等级门限与队列容量；
+    // 经这里设置的值优先于延迟加载的配置文件中的同名项；调大队列上限时先在调用线程上备好存储
+    void setLevel(LogLevel lvl);
+    void setMaxQueueSize(size_t n);
+
+    bool enabled(LogLevel lvl) const { return lvl <= gateLevel.load(std::memory_order_relaxed); }
+    bool traceEnabled() const        { return traceOn.load(std::memory_order_relaxed); }
+
+    // 默认实例的等级门限，不触发 instance() 的创建；实例创建前保持放行
+    static bool defaultEnabled(LogLevel lvl) { return lvl <= defaultGate.load(std::memory_order_relaxed); }
+
+    static bool loadConfigFromFile(const std::string& path, LogConfig& cfg);
 
-    std::mutex              mtx;
-    std::condition_variable cv;
-    std::queue<LogTask>     queue;
-    bool                    exitFlag = false;
+    LogStats stats() const;
 
-    std::ofstream file;
-    size_t        currentSize    = 0;
-    std::string   currentFileName;
+    // 取某阶段的耗时分布（单位为 TSC 周期，无 TSC 的平台为纳秒）；
+    // 未以 CSLOG_PROFILE_WORKER 编译时返回 false
+    bool workerProfile(WorkerStage stage, LatencyHistogram& out) const;
 
-    std::thread   worker;
+    void push(LogLevel lvl, const std::string& msg);
+    void push(LogLevel lvl, std::string&& msg);
+    void push(LogTask&& task);
+    // onWorker 为 false 时在当前线程生成正文；为 true 时由后台线程在过滤之后生成，
+    // 此时可调用对象捕获的状态必须在后台线程上可安全读取
+    void pushLazy(LogLevel lvl, std::unique_ptr<LazyText> text, bool onWorker, const CallSite* site = nullptr);
+    void pushLazy(LogLevel lvl, LazyRender render, void* fn, const CallSite* site = nullptr);
+    void pushSpan(const char* name, uint64_t beginTicks, uint64_t endTicks, uint8_t clockMode);
+
+    // 等待调用前已入队的记录全部写入文件并 fsync；超时、已停止、处于降级模式
+    // 或在后台线程上调用时返回 false
+    bool flush(std::chrono::milliseconds timeout);
+
+    // stop() 写完队列中的全部记录（含 block 策略下正在等待空位的记录）后返回；stop(deadline) 到期后放弃剩余记录，
+    // 返回放弃的条数（正在进行的单次写入不会被打断）
+    void     stop();
+    uint64_t stop(std::chrono::steady_clock::time_point deadline);
+
+    // 协程前端（coro.h）使用的非阻塞接口。done(arg, ok) 在后台线程上调用，调用时不持有内部锁。
+    // pushAsync：task.tid 为 0 时取当前线程；入队或按策略丢弃后返回 true；block 策略下队列已满时暂存任务并返回 false，
+    //            由后台线程腾出空间后代为入队再回调 ok = true，stop(deadline) 放弃时回调 ok = false。
+    // flushAsync：登记一次刷新屏障并返回 true，完成后回调（ok 含义同 flush()）；已停止时返回 false。
+    using AsyncDone = void (*)(void* arg, bool ok);
+    bool pushAsync(LogTask&& task, AsyncDone done, void* arg);
+    bool flushAsync(AsyncDone done, void* arg);
+
+private:
+    Logger();
+    Logger(const LogConfig& config, bool asDefault);
 
-    std::vector<char> fileBuffer;
-    size_t            bytesSinceFlush = 0;
+    friend bool init(const LogConfig& config);
+    friend class LogLine;
 
-    void workerThread();
-    void rotate();
-    void openFileOnce();
+    struct Impl;
+    Impl* impl;
 
-    void cleanupOldLogFiles();
-    void createNewLogFile();
+    std::atomic<int>  gateLevel{LOG_LEVEL_DEBUG};
+    std::atomic<bool> traceOn{false};
+
+    static std::atomic<int> defaultGate;
 };
 
 class LogLine {
 public:
-    LogLine(LogLevel lvl, const char* file, int line, const char* func)
-        : level(lvl), fileName(file), lineNum(line), funcName(func) {}
-
-    LogLine(LogLevel lvl) : level(lvl) {}
+    CSLOG_COLD LogLine(LogLevel lvl, const char* file, int line, const char* func, const CallSite* site = nullptr);
+    CSLOG_COLD explicit LogLine(LogLevel lvl, const CallSite* site = nullptr);
+    CSLOG_COLD LogLine(Logger& logger, LogLevel lvl, const char* file, int line, const char* func, const CallSite* site = nullptr);
+    CSLOG_COLD LogLine(Logger& logger, LogLevel lvl, const CallSite* site = nullptr);
 
-    ~LogLine();
+    CSLOG_COLD ~LogLine();
 
-    std::ostringstream& stream() { return ss; }
+    std::ostream& stream() { return os; }
 
 private:
-    LogLevel    level;
-    const char* fileName = nullptr;
-    int         lineNum  = 0;
-    const char* funcName = nullptr;
+    static uint64_t beginSample(Logger* target);
+    void            admit();
+
+    Logger*         logger      = nullptr;
+    const CallSite* site        = nullptr;
+    uint64_t        sampleBegin = 0;  // 非 0 表示本条被采样（见 latencySampleEvery）
+    uint64_t        sampleBuilt = 0;
+    LogLevel        level;
+    const char*     fileName    = nullptr;
+    int             lineNum     = 0;
+    const char*     funcName    = nullptr;
+    bool            skipped     = false;  // 被调用点采样或等级限速跳过
+
+    LogText      text;
+    LogStreamBuf buf{text};
+    std::ostream os{&buf};
+};
+
+// 让宏展开为 `cond ? (void)0 : LogVoidify() & stream << ...`，两个分支类型一致
+struct LogVoidify {
+    void operator&(std::ostream&) {}
+};
+
+template <class F>
+CSLOG_COLD void logLazy(Logger& logger, LogLevel lvl, bool onWorker, const CallSite* site, F&& fn)
+{
+    if (onWorker) {
+        logger.pushLazy(lvl, std::make_unique<LazyTextFn<std::decay_t<F>>>(std::forward<F>(fn)), true, site);
+        return;
+    }
+
+    using Fn = std::remove_reference_t<F>;
+    logger.pushLazy(lvl, &renderLazyThunk<Fn>,
+                    const_cast<void*>(static_cast<const void*>(std::addressof(fn))), site);
+}
+
+// RAII 计时区间：析构时把 [begin, end) 作为一个 Chrome Trace 事件送入异步队列。
+// name 必须是静态生命周期的字符串（通常是字面量），队列中只保存指针。
+class ScopeTimer {
+public:
+    explicit ScopeTimer(const char* name);
+    ScopeTimer(Logger& logger, const char* name);
+    ~ScopeTimer();
+
+    ScopeTimer(const ScopeTimer&)            = delete;
+    ScopeTimer& operator=(const ScopeTimer&) = delete;
 
-    std::ostringstream ss;
+private:
+    Logger&     logger;
+    const char* name;
+    uint64_t    beginTicks = 0;
+    uint8_t     clockMode  = 0;
 };
 
 } // namespace csLog
 
-#define LOG_ERROR   csLog::LogLine(csLog::LOG_LEVEL_ERROR).stream()
-#define LOG_WARN    csLog::LogLine(csLog::LOG_LEVEL_WARN ).stream()
-#define LOG_INFO    csLog::LogLine(csLog::LOG_LEVEL_INFO ).stream()
-#define LOG_DEBUG   csLog::LogLine(csLog::LOG_LEVEL_DEBUG).stream()
+#define CSLOG_CONCAT_IMPL(a, b) a##b
+#define CSLOG_CONCAT(a, b)      CSLOG_CONCAT_IMPL(a, b)
+
+#define LOG_SCOPE_TIMER(name) csLog::ScopeTimer CSLOG_CONCAT(cslogScopeTimer_, __COUNTER__)(name)
+
+// 每条日志语句一个静态 CallSite；常量初始化，没有局部静态变量的加锁检查
+#define CSLOG_CALLSITE()                                                                    \
+    [] { static csLog::CallSite cslogSite{__FILE__, __LINE__}; return &cslogSite; }()
+
+// 未通过等级门限时不构造 LogLine，也不对 << 右侧的表达式求值
+#define CSLOG_LINE(gate, ...)                                                               \
+    !CSLOG_UNLIKELY(gate) ? (void)0                                                         \
+        : csLog::LogVoidify() & csLog::LogLine(__VA_ARGS__, CSLOG_CALLSITE()).stream()
+
+#define CSLOG_DEFAULT_GATE(lvl)        csLog::Logger::defaultEnabled(lvl)
+
+#define LOG_ERROR   CSLOG_LINE(CSLOG_DEFAULT_GATE(csLog::LOG_LEVEL_ERROR), csLog::LOG_LEVEL_ERROR)
+#define LOG_WARN    CSLOG_LINE(CSLOG_DEFAULT_GATE(csLog::LOG_LEVEL_WARN ), csLog::LOG_LEVEL_WARN )
+#define LOG_INFO    CSLOG_LINE(CSLOG_DEFAULT_GATE(csLog::LOG_LEVEL_INFO ), csLog::LOG_LEVEL_INFO )
+#define LOG_DEBUG   CSLOG_LINE(CSLOG_DEFAULT_GATE(csLog::LOG_LEVEL_DEBUG), csLog::LOG_LEVEL_DEBUG)
+
+#define LOG_ERROR_F CSLOG_LINE(CSLOG_DEFAULT_GATE(csLog::LOG_LEVEL_ERROR), csLog::LOG_LEVEL_ERROR, __FILE__, __LINE__, __FUNCTION__)
+#define LOG_WARN_F  CSLOG_LINE(CSLOG_DEFAULT_GATE(csLog::LOG_LEVEL_WARN ), csLog::LOG_LEVEL_WARN,  __FILE__, __LINE__, __FUNCTION__)
+#define LOG_INFO_F  CSLOG_LINE(CSLOG_DEFAULT_GATE(csLog::LOG_LEVEL_INFO ), csLog::LOG_LEVEL_INFO,  __FILE__, __LINE__, __FUNCTION__)
+#define LOG_DEBUG_F CSLOG_LINE(CSLOG_DEFAULT_GATE(csLog::LOG_LEVEL_DEBUG), csLog::LOG_LEVEL_DEBUG, __FILE__, __LINE__, __FUNCTION__)
+
+// 传入返回字符串（或可输出到 ostream 的值）的可调用对象，只有记录会被输出时才调用。
+// _ASYNC 版本把调用推迟到后台线程，按值捕获或保证被捕获状态在后台线程可读。
+#define CSLOG_LAZY(gate, logger, lvl, onWorker, ...)                                          \
+    (!CSLOG_UNLIKELY(gate) ? (void)0 : csLog::logLazy((logger), (lvl), (onWorker), CSLOG_CALLSITE(), __VA_ARGS__))
+
+#define LOG_ERROR_LAZY(...)       CSLOG_LAZY(CSLOG_DEFAULT_GATE(csLog::LOG_LEVEL_ERROR), csLog::Logger::instance(), csLog::LOG_LEVEL_ERROR, false, __VA_ARGS__)
+#define LOG_WARN_LAZY(...)        CSLOG_LAZY(CSLOG_DEFAULT_GATE(csLog::LOG_LEVEL_WARN ), csLog::Logger::instance(), csLog::LOG_LEVEL_WARN,  false, __VA_ARGS__)
+#define LOG_INFO_LAZY(...)        CSLOG_LAZY(CSLOG_DEFAULT_GATE(csLog::LOG_LEVEL_INFO ), csLog::Logger::instance(), csLog::LOG_LEVEL_INFO,  false, __VA_ARGS__)
+#define LOG_DEBUG_LAZY(...)       CSLOG_LAZY(CSLOG_DEFAULT_GATE(csLog::LOG_LEVEL_DEBUG), csLog::Logger::instance(), csLog::LOG_LEVEL_DEBUG, false, __VA_ARGS__)
+
+#define LOG_ERROR_LAZY_ASYNC(...) CSLOG_LAZY(CSLOG_DEFAULT_GATE(csLog::LOG_LEVEL_ERROR), csLog::Logger::instance(), csLog::LOG_LEVEL_ERROR, true, __VA_ARGS__)
+#define LOG_WARN_LAZY_ASYNC(...)  CSLOG_LAZY(CSLOG_DEFAULT_GATE(csLog::LOG_LEVEL_WARN ), csLog::Logger::instance(), csLog::LOG_LEVEL_WARN,  true, __VA_ARGS__)
+#define LOG_INFO_LAZY_ASYNC(...)  CSLOG_LAZY(CSLOG_DEFAULT_GATE(csLog::LOG_LEVEL_INFO ), csLog::Logger::instance(), csLog::LOG_LEVEL_INFO,  true, __VA_ARGS__)
+#define LOG_DEBUG_LAZY_ASYNC(...) CSLOG_LAZY(CSLOG_DEFAULT_GATE(csLog::LOG_LEVEL_DEBUG), csLog::Logger::instance(), csLog::LOG_LEVEL_DEBUG, true, __VA_ARGS__)
+
+#define LOG_LAZY_TO(logger, lvl, ...)       CSLOG_LAZY((logger).enabled(lvl), (logger), (lvl), false, __VA_ARGS__)
+#define LOG_LAZY_ASYNC_TO(logger, lvl, ...) CSLOG_LAZY((logger).enabled(lvl), (logger), (lvl), true,  __VA_ARGS__)
+
+#define LOG_ERROR_TO(logger)   CSLOG_LINE((logger).enabled(csLog::LOG_LEVEL_ERROR), (logger), csLog::LOG_LEVEL_ERROR)
+#define LOG_WARN_TO(logger)    CSLOG_LINE((logger).enabled(csLog::LOG_LEVEL_WARN ), (logger), csLog::LOG_LEVEL_WARN )
+#define LOG_INFO_TO(logger)    CSLOG_LINE((logger).enabled(csLog::LOG_LEVEL_INFO ), (logger), csLog::LOG_LEVEL_INFO )
+#define LOG_DEBUG_TO(logger)   CSLOG_LINE((logger).enabled(csLog::LOG_LEVEL_DEBUG), (logger), csLog::LOG_LEVEL_DEBUG)
 
-#define LOG_ERROR_F csLog::LogLine(csLog::LOG_LEVEL_ERROR, __FILE__, __LINE__, __FUNCTION__).stream()
-#define LOG_WARN_F  csLog::LogLine(csLog::LOG_LEVEL_WARN,  __FILE__, __LINE__, __FUNCTION__).stream()
-#define LOG_INFO_F  csLog::LogLine(csLog::LOG_LEVEL_INFO,  __FILE__, __LINE__, __FUNCTION__).stream()
-#define LOG_DEBUG_F csLog::LogLine(csLog::LOG_LEVEL_DEBUG, __FILE__, __LINE__, __FUNCTION__).stream()
+#define LOG_ERROR_F_TO(logger) CSLOG_LINE((logger).enabled(csLog::LOG_LEVEL_ERROR), (logger), csLog::LOG_LEVEL_ERROR, __FILE__, __LINE__, __FUNCTION__)
+#define LOG_WARN_F_TO(logger)  CSLOG_LINE((logger).enabled(csLog::LOG_LEVEL_WARN ), (logger), csLog::LOG_LEVEL_WARN,  __FILE__, __LINE__, __FUNCTION__)
+#define LOG_INFO_F_TO(logger)  CSLOG_LINE((logger).enabled(csLog::LOG_LEVEL_INFO ), (logger), csLog::LOG_LEVEL_INFO,  __FILE__, __LINE__, __FUNCTION__)
+#define LOG_DEBUG_F_TO(logger) CSLOG_LINE((logger).enabled(csLog::LOG_LEVEL_DEBUG), (logger), csLog::LOG_LEVEL_DEBUG, __FILE__, __LINE__, __FUNCTION__)
 
 #endif // CSLOG_H
@@ -0,0 +1,37 @@
+#ifndef CSLOG_FORMAT_H
+#define CSLOG_FORMAT_H
+
+#include <cstdint>
+#include <ctime>
+#include <string>
+#include "csLog.h"
+
+namespace csLog {
+
+// 一条记录的墙上时间拆分结果，供各布局复用
+struct TimeParts {
+    int64_t sec  = 0;
+    int64_t nsec = 0;
+    std::tm tm{};
+    char    date[16] = {};
+    char    time[16] = {};
+};
+
+// 同一秒内的记录复用 localtime_r / strftime 的结果；非线程安全，每个消费线程各持一份
+class TimeCache {
+public:
+    const TimeParts& get(int64_t wallNs);
+
+private:
+    TimeParts parts;
+    bool      valid = false;
+};
+
+// 内置布局，不追加换行
+void formatJson  (const LogTask& task, const TimeParts& tp, std::string& out);
+void formatLogfmt(const LogTask& task, const TimeParts& tp, std::string& out);
+void formatText  (const LogTask& task, const TimeParts& tp, std::string& out);
+
+} // namespace csLog
+
+#endif // CSLOG_FORMAT_H
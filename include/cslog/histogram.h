@@ -0,0 +1,161 @@
+#ifndef CSLOG_HISTOGRAM_H
+#define CSLOG_HISTOGRAM_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace csLog {
+
+// HDR 风格的对数-线性直方图：小于 SUB_BUCKETS 的值逐个计数，
+// 更大的值按 2 的幂分段、每段再等分为 SUB_BUCKETS 个桶，相对误差不超过 1/SUB_BUCKETS。
+// 用于纳秒 / 时钟周期的分位统计；非线程安全，每个线程各持一份，结束后 merge。
+class LatencyHistogram {
+public:
+    static constexpr int    SUB_BITS    = 5;
+    static constexpr size_t SUB_BUCKETS = size_t(1) << SUB_BITS;
+    static constexpr size_t BUCKETS     = (64 - SUB_BITS + 1) * SUB_BUCKETS;
+
+    void record(uint64_t v)
+    {
+        ++counts[indexOf(v)];
+        ++total;
+        sum += v;
+        if (v > maxValue) maxValue = v;
+        if (v < minValue) minValue = v;
+    }
+
+    void merge(const LatencyHistogram& o)
+    {
+        for (size_t i = 0; i < BUCKETS; ++i) counts[i] += o.counts[i];
+        total += o.total;
+        sum   += o.sum;
+        if (o.maxValue > maxValue) maxValue = o.maxValue;
+        if (o.minValue < minValue) minValue = o.minValue;
+    }
+
+    void reset() { *this = LatencyHistogram(); }
+
+    uint64_t count() const { return total; }
+    uint64_t max() const   { return maxValue; }
+    uint64_t min() const   { return total ? minValue : 0; }
+    double   mean() const  { return total ? double(sum) / double(total) : 0.0; }
+
+    // q 取 [0, 1]；返回所在桶的上界，不超过实际最大值
+    uint64_t percentile(double q) const
+    {
+        if (total == 0) return 0;
+
+        uint64_t rank = static_cast<uint64_t>(q * double(total - 1)) + 1;
+        uint64_t seen = 0;
+        for (size_t i = 0; i < BUCKETS; ++i) {
+            seen += counts[i];
+            if (seen >= rank) {
+                uint64_t v = upperBound(i);
+                return v < maxValue ? v : maxValue;
+            }
+        }
+        return maxValue;
+    }
+
+    static size_t indexOf(uint64_t v)
+    {
+        if (v < SUB_BUCKETS) return static_cast<size_t>(v);
+
+        int    shift = highestBit(v) - SUB_BITS;
+        size_t sub   = static_cast<size_t>(v >> shift) & (SUB_BUCKETS - 1);
+        return (static_cast<size_t>(shift) + 1) * SUB_BUCKETS + sub;
+    }
+
+    static uint64_t upperBound(size_t idx)
+    {
+        if (idx < SUB_BUCKETS) return idx;
+
+        size_t shift = idx / SUB_BUCKETS - 1;
+        size_t sub   = idx % SUB_BUCKETS;
+        return ((uint64_t(SUB_BUCKETS + sub + 1)) << shift) - 1;
+    }
+
+private:
+    friend class AtomicHistogram;
+
+    static int highestBit(uint64_t v)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        return 63 - __builtin_clzll(v);
+#elif defined(_MSC_VER) && defined(_M_X64)
+        unsigned long idx;
+        _BitScanReverse64(&idx, v);
+        return static_cast<int>(idx);
+#else
+        int n = 0;
+        while (v >>= 1) ++n;
+        return n;
+#endif
+    }
+
+    uint64_t counts[BUCKETS] = {};
+    uint64_t total    = 0;
+    uint64_t sum      = 0;
+    uint64_t maxValue = 0;
+    uint64_t minValue = UINT64_MAX;
+};
+
+// 无锁版本：写者以 relaxed 原子累加，读者随时取 snapshot()，多个写者并发安全。
+// 快照不是原子的整体视图，计数之间可能相差正在写入的一两个样本。
+class AtomicHistogram {
+public:
+    void record(uint64_t v)
+    {
+        counts[LatencyHistogram::indexOf(v)].fetch_add(1, std::memory_order_relaxed);
+        total.fetch_add(1, std::memory_order_relaxed);
+        sum.fetch_add(v, std::memory_order_relaxed);
+
+        uint64_t cur = maxValue.load(std::memory_order_relaxed);
+        while (v > cur && !maxValue.compare_exchange_weak(cur, v, std::memory_order_relaxed)) {}
+        cur = minValue.load(std::memory_order_relaxed);
+        while (v < cur && !minValue.compare_exchange_weak(cur, v, std::memory_order_relaxed)) {}
+    }
+
+    LatencyHistogram snapshot() const
+    {
+        LatencyHistogram h;
+        for (size_t i = 0; i < LatencyHistogram::BUCKETS; ++i) {
+            h.counts[i] = counts[i].load(std::memory_order_relaxed);
+        }
+        h.total    = total.load(std::memory_order_relaxed);
+        h.sum      = sum.load(std::memory_order_relaxed);
+        h.maxValue = maxValue.load(std::memory_order_relaxed);
+        h.minValue = minValue.load(std::memory_order_relaxed);
+        return h;
+    }
+
+    // 取出自上次 drain 以来的样本并清零，用于按周期输出
+    LatencyHistogram drain()
+    {
+        LatencyHistogram h;
+        for (size_t i = 0; i < LatencyHistogram::BUCKETS; ++i) {
+            h.counts[i] = counts[i].exchange(0, std::memory_order_relaxed);
+        }
+        h.total    = total.exchange(0, std::memory_order_relaxed);
+        h.sum      = sum.exchange(0, std::memory_order_relaxed);
+        h.maxValue = maxValue.exchange(0, std::memory_order_relaxed);
+        h.minValue = minValue.exchange(UINT64_MAX, std::memory_order_relaxed);
+        return h;
+    }
+
+private:
+    std::atomic<uint64_t> counts[LatencyHistogram::BUCKETS] = {};
+    std::atomic<uint64_t> total{0};
+    std::atomic<uint64_t> sum{0};
+    std::atomic<uint64_t> maxValue{0};
+    std::atomic<uint64_t> minValue{UINT64_MAX};
+};
+
+} // namespace csLog
+
+#endif // CSLOG_HISTOGRAM_H
@@ -0,0 +1,258 @@
+#ifndef CSLOG_STATIC_LOGGER_H
+#define CSLOG_STATIC_LOGGER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "csLog.h"
+#include "format.h"
+
+// 编译期组合的日志管线：输出目标与布局都是模板参数，
+// 后台线程对 sink 的遍历由折叠表达式展开，不经过虚函数和配置分支。
+// 与运行时配置的 Logger 单例互不影响，可并存。
+//
+//   csLog::StaticLogger<csLog::FileSink<csLog::JsonLayout>,
+//                       csLog::ConsoleSink<csLog::TextLayout>>
+//       feedLog({csLog::LOG_LEVEL_INFO},
+//               csLog::FileSink<csLog::JsonLayout>("./logs/feed.log"),
+//               csLog::ConsoleSink<csLog::TextLayout>());
+//
+//   SLOG_INFO(feedLog) << "tick " << seq;
+
+namespace csLog {
+
+struct JsonLayout {
+    static void format(const LogTask& t, const TimeParts& tp, std::string& out) { formatJson(t, tp, out); }
+};
+
+struct LogfmtLayout {
+    static void format(const LogTask& t, const TimeParts& tp, std::string& out) { formatLogfmt(t, tp, out); }
+};
+
+struct TextLayout {
+    static void format(const LogTask& t, const TimeParts& tp, std::string& out) { formatText(t, tp, out); }
+};
+
+template <class Layout = JsonLayout>
+class ConsoleSink {
+public:
+    void write(const LogTask& task, const TimeParts& tp)
+    {
+        buf.clear();
+        buf += levelColor(task.lvl);
+        Layout::format(task, tp, buf);
+        buf += '\n';
+        buf += COLOR_RESET;
+        std::fwrite(buf.data(), 1, buf.size(), stdout);
+    }
+
+    void flush() { std::fflush(stdout); }
+
+private:
+    std::string buf;
+};
+
+// 追加写入单个文件；不做滚动，按 32KB / 每批结束 / ERROR 触发 flush
+template <class Layout = JsonLayout>
+class FileSink {
+public:
+    explicit FileSink(const std::string& path)
+        : fp(std::fopen(path.c_str(), "ab"))
+    {
+        if (fp) std::setvbuf(fp, nullptr, _IOFBF, 64 * 1024);
+    }
+
+    FileSink(FileSink&& o) noexcept : fp(o.fp), buf(std::move(o.buf)), unflushed(o.unflushed) { o.fp = nullptr; }
+    FileSink(const FileSink&)            = delete;
+    FileSink& operator=(const FileSink&) = delete;
+
+    ~FileSink()
+    {
+        if (fp) std::fclose(fp);
+    }
+
+    void write(const LogTask& task, const TimeParts& tp)
+    {
+        if (!fp) return;
+
+        buf.clear();
+        Layout::format(task, tp, buf);
+        buf += '\n';
+        std::fwrite(buf.data(), 1, buf.size(), fp);
+        unflushed += buf.size();
+
+        if (task.lvl <= LOG_LEVEL_ERROR || unflushed >= 32 * 1024) {
+            flush();
+        }
+    }
+
+    void flush()
+    {
+        if (fp && unflushed) std::fflush(fp);
+        unflushed = 0;
+    }
+
+private:
+    std::FILE*  fp = nullptr;
+    std::string buf;
+    size_t      unflushed = 0;
+};
+
+struct StaticLoggerOptions {
+    LogLevel level        = LOG_LEVEL_DEBUG;
+    size_t   maxQueueSize = 20000;
+    bool     dropWhenFull = false;
+};
+
+template <class... Sinks>
+class StaticLogger {
+public:
+    explicit StaticLogger(StaticLoggerOptions opts, Sinks... s)
+        : opts(opts), level(opts.level), sinks(std::move(s)...)
+    {
+        worker = std::thread(&StaticLogger::workerThread, this);
+    }
+
+    ~StaticLogger() { stop(); }
+
+    StaticLogger(const StaticLogger&)            = delete;
+    StaticLogger& operator=(const StaticLogger&) = delete;
+
+    bool enabled(LogLevel lvl) const
+    {
+        return lvl <= level.load(std::memory_order_relaxed);
+    }
+
+    void setLevel(LogLevel lvl) { level.store(lvl, std::memory_order_relaxed); }
+
+    void push(LogTask&& task)
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+
+        if (queue.size() >= opts.maxQueueSize) {
+            if (opts.dropWhenFull) return;
+            spaceCv.wait(lock, [&] { return queue.size() < opts.maxQueueSize || exitFlag; });
+        }
+
+        queue.push_back(std::move(task));
+        if (queue.size() == 1) cv.notify_one();
+    }
+
+    void stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            exitFlag = true;
+        }
+        cv.notify_all();
+        spaceCv.notify_all();
+        if (worker.joinable()) worker.join();
+    }
+
+    template <size_t I>
+    auto& sink() { return std::get<I>(sinks); }
+
+private:
+    void workerThread()
+    {
+        std::vector<LogTask> batch;
+        TimeCache           timeCache;
+
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(mtx);
+                cv.wait_for(lock, std::chrono::seconds(1), [&] { return exitFlag || !queue.empty(); });
+
+                if (exitFlag && queue.empty()) break;
+
+                batch.swap(queue);
+            }
+            spaceCv.notify_all();
+
+            for (const LogTask& task : batch) {
+                const TimeParts& tp = timeCache.get(static_cast<int64_t>(task.ticks));
+                std::apply([&](auto&... s) { (s.write(task, tp), ...); }, sinks);
+            }
+            batch.clear();
+
+            std::apply([](auto&... s) { (s.flush(), ...); }, sinks);
+        }
+
+        std::apply([](auto&... s) { (s.flush(), ...); }, sinks);
+    }
+
+    StaticLoggerOptions     opts;
+    std::atomic<int>        level;
+    std::tuple<Sinks...>    sinks;
+
+    std::mutex              mtx;
+    std::condition_variable cv;
+    std::condition_variable spaceCv;
+    std::vector<LogTask>    queue;
+    bool                    exitFlag = false;
+
+    std::thread             worker;
+};
+
+// StaticLogger 的流式前端；时间戳直接取 system_clock 纳秒
+template <class L>
+class StaticLogLine {
+public:
+    CSLOG_COLD StaticLogLine(L& logger, LogLevel lvl, const char* file = nullptr, int line = 0, const char* func = nullptr)
+        : logger(logger)
+    {
+        task.lvl  = lvl;
+        task.file = file;
+        task.line = line;
+        task.func = func;
+    }
+
+    CSLOG_COLD ~StaticLogLine()
+    {
+        task.ticks = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count());
+        buf.finish();
+        while (!task.text.empty() && (task.text.back() == '\n' || task.text.back() == '\r')) {
+            task.text.pop_back();
+        }
+        logger.push(std::move(task));
+    }
+
+    std::ostream& stream() { return os; }
+
+private:
+    L&                 logger;
+    LogTask            task;
+    LogStreamBuf       buf{task.text};
+    std::ostream       os{&buf};
+};
+
+using StaticLogVoidify = LogVoidify;
+
+} // namespace csLog
+
+#define CSLOG_STATIC_LINE(logger, lvl, ...)                                                   \
+    !CSLOG_UNLIKELY((logger).enabled(lvl)) ? (void)0                                          \
+        : csLog::StaticLogVoidify() &                                                         \
+          csLog::StaticLogLine<std::remove_reference_t<decltype(logger)>>((logger), (lvl), __VA_ARGS__).stream()
+
+#define SLOG_ERROR(logger)   CSLOG_STATIC_LINE(logger, csLog::LOG_LEVEL_ERROR, nullptr)
+#define SLOG_WARN(logger)    CSLOG_STATIC_LINE(logger, csLog::LOG_LEVEL_WARN,  nullptr)
+#define SLOG_INFO(logger)    CSLOG_STATIC_LINE(logger, csLog::LOG_LEVEL_INFO,  nullptr)
+#define SLOG_DEBUG(logger)   CSLOG_STATIC_LINE(logger, csLog::LOG_LEVEL_DEBUG, nullptr)
+
+#define SLOG_ERROR_F(logger) CSLOG_STATIC_LINE(logger, csLog::LOG_LEVEL_ERROR, __FILE__, __LINE__, __FUNCTION__)
+#define SLOG_WARN_F(logger)  CSLOG_STATIC_LINE(logger, csLog::LOG_LEVEL_WARN,  __FILE__, __LINE__, __FUNCTION__)
+#define SLOG_INFO_F(logger)  CSLOG_STATIC_LINE(logger, csLog::LOG_LEVEL_INFO,  __FILE__, __LINE__, __FUNCTION__)
+#define SLOG_DEBUG_F(logger) CSLOG_STATIC_LINE(logger, csLog::LOG_LEVEL_DEBUG, __FILE__, __LINE__, __FUNCTION__)
+
+#endif // CSLOG_STATIC_LOGGER_H
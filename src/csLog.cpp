@@ -1,19 +1,55 @@
 #include "cslog/csLog.h"
+#include "cslog/format.h"
+#include "cslog/histogram.h"
+#include <yaml-cpp/yaml.h>
 #include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <chrono>
+#include <memory>
 #include <algorithm>
 #include <filesystem>
 #include <vector>
+#include <deque>
+#include <unordered_map>
 #include <ctime>
 
+#include <atomic>
+#include <cmath>
+#include <cctype>
+#include <string_view>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+
+#ifdef _WIN32
+#include <process.h>
+#include <io.h>
+#else
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <time.h>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64)
+#define CSLOG_HAS_RDTSC 1
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#include <cpuid.h>
+#endif
+#endif
+
 namespace csLog {
 
-static LogConfig g_cfg;
-LogConfig& config() { return g_cfg; }
+LogConfig& config() { return Logger::instance().config(); }
 
-static std::string jsonEscape(const std::string& s)
+static void appendJsonEscaped(std::string& out, std::string_view s)
 {
-    std::string out;
-    out.reserve(s.size() + 8);
     for (char c : s) {
         switch (c) {
             case '\"': out += "\\\""; break;
@@ -33,119 +69,201 @@ static std::string jsonEscape(const std::string& s)
                 }
         }
     }
-    return out;
 }
 
-Logger& Logger::instance() {
-    static Logger inst;
-    return inst;
+static std::string jsonEscape(std::string_view s)
+{
+    std::string out;
+    out.reserve(s.size() + 8);
+    appendJsonEscaped(out, s);
+    return out;
 }
 
-Logger::Logger()
+static int64_t steadyNowNs()
 {
-    loadConfigFromFile();
-    worker = std::thread(&Logger::workerThread, this);
+    using namespace std::chrono;
+    return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
 }
 
-Logger::~Logger() {
-    stop();
+static int64_t wallNowNs()
+{
+    using namespace std::chrono;
+    return duration_cast<nanoseconds>(system_clock::now().time_since_epoch()).count();
 }
 
-void Logger::loadConfigFromFile()
-{
-    YAML::Node root = YAML::LoadFile(CSLOG_CONFIG_PATH);
+// 生产者只读原始 tick；后台线程用周期性校准的频率与偏移换算成墙上时间。
+// System 模式下 tick 即 system_clock 纳秒，换算为恒等映射。
+class TickClock {
+public:
+    enum Mode { System, Tsc, MonotonicRaw };
 
-    if (auto node = root["csLog"]) {
+    void setMode(const std::string& name)
+    {
+        Mode m = System;
+        if (name == "tsc") {
+            if (hasInvariantTsc())        m = Tsc;
+            else if (hasMonotonicRaw())   m = MonotonicRaw;
+        }
+        mode.store(m, std::memory_order_relaxed);
+        calibrated = false;
+    }
 
-        auto get = [&](const char* key, auto& dst) {
-            if (node[key]) dst = node[key].as<std::decay_t<decltype(dst)>>();
-        };
+    uint8_t currentMode() const
+    {
+        return static_cast<uint8_t>(mode.load(std::memory_order_relaxed));
+    }
 
-        get("enable",           config().enable);
-        get("toConsole",        config().toConsole);
-        get("toFile",           config().toFile);
-        get("logPath",          config().logPath);
-        get("fileName",         config().baseName);
-        get("maxFileCount",     config().maxFileCount);
-        get("maxFileSize",      config().maxFileSize);
-        get("maxLogsTotalSize", config().maxLogsTotalSize);
-        get("maxQueueSize",     config().maxQueueSize);
-        get("queuePolicy",      config().queuePolicy);
+    uint64_t now() const
+    {
+        return read(currentMode());
+    }
 
-        if (node["level"]) {
-            std::string s = node["level"].as<std::string>();
-            std::transform(s.begin(), s.end(), s.begin(), ::toupper);
-            switch (s[0]) {
-                case 'E': config().level = LOG_LEVEL_ERROR; break;
-                case 'W': config().level = LOG_LEVEL_WARN;  break;
-                case 'I': config().level = LOG_LEVEL_INFO;  break;
-                case 'D': config().level = LOG_LEVEL_DEBUG; break;
-                default:  config().level = LOG_LEVEL_INFO;  break;
+    uint64_t read(uint8_t m) const
+    {
+        switch (m) {
+#ifdef CSLOG_HAS_RDTSC
+            case Tsc:          return __rdtsc();
+#endif
+#if defined(__linux__)
+            case MonotonicRaw: {
+                timespec ts;
+                ::clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+                return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + ts.tv_nsec;
             }
+#endif
+            default:           return static_cast<uint64_t>(wallNowNs());
         }
     }
-}
-
-void Logger::cleanupOldLogFiles()
-{
-    namespace fs = std::filesystem;
-
-    if (config().maxLogsTotalSize == 0) return;
-
-    std::vector<fs::directory_entry> files;
 
-    std::string prefix = config().baseName + "_";
-    std::string suffix = ".log";
-
-    if (fs::exists(config().logPath)) {
-        for (auto& e : fs::directory_iterator(config().logPath)) {
-            if (!e.is_regular_file()) continue;
-
-            std::string name = e.path().filename().string();
+    // 仅后台线程调用
+    void calibrate()
+    {
+        if (mode.load(std::memory_order_relaxed) == System) return;
+
+        uint64_t ticks  = 0;
+        int64_t  wall   = 0;
+        int64_t  steady = 0;
+        sample(ticks, wall, steady);
+
+        if (!calibrated) {
+            baseTicks  = ticks;
+            baseSteady = steady;
+
+            // 初始频率：短暂忙等得到粗略估计，后续校准逐步以更长基线修正
+            int64_t until = steady + 2000000;
+            while (steadyNowNs() < until) {}
+            sample(ticks, wall, steady);
+            calibrated = true;
+        }
 
-            if (name.rfind(prefix, 0) == 0 &&
-                name.size() > prefix.size() + suffix.size() &&
-                name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0)
-            {
-                files.push_back(e);
-            }
+        if (steady > baseSteady && ticks > baseTicks) {
+            nsPerTick = static_cast<double>(steady - baseSteady) /
+                        static_cast<double>(ticks - baseTicks);
         }
+        anchorTicks = ticks;
+        anchorWall  = wall;
     }
 
-    if (files.empty()) return;
+    // m 为打点时的模式：配置延迟加载时，切换前入队的记录仍是 System tick
+    int64_t toWallNs(uint64_t ticks, uint8_t m) const
+    {
+        if (m == System) {
+            return static_cast<int64_t>(ticks);
+        }
+        double delta = static_cast<double>(static_cast<int64_t>(ticks - anchorTicks)) * nsPerTick;
+        return anchorWall + static_cast<int64_t>(std::llround(delta));
+    }
 
-    std::uintmax_t totalSize = 0;
-    for (auto& f : files) {
-        totalSize += f.file_size();
+    int64_t toNs(uint64_t ticks, uint8_t m) const
+    {
+        if (m == System) {
+            return static_cast<int64_t>(ticks);
+        }
+        return static_cast<int64_t>(std::llround(static_cast<double>(ticks) * nsPerTick));
     }
 
-    if (totalSize <= config().maxLogsTotalSize)
-        return;
+private:
+    static bool hasInvariantTsc()
+    {
+#ifdef CSLOG_HAS_RDTSC
+#ifdef _MSC_VER
+        int regs[4];
+        __cpuid(regs, 0x80000000);
+        if (static_cast<unsigned>(regs[0]) < 0x80000007u) return false;
+        __cpuid(regs, 0x80000007);
+        return (regs[3] & (1 << 8)) != 0;
+#else
+        unsigned eax = 0, ebx = 0, ecx = 0, edx = 0;
+        if (__get_cpuid_max(0x80000000u, nullptr) < 0x80000007u) return false;
+        __get_cpuid(0x80000007u, &eax, &ebx, &ecx, &edx);
+        return (edx & (1u << 8)) != 0;
+#endif
+#else
+        return false;
+#endif
+    }
 
-    std::sort(files.begin(), files.end(),
-              [](const fs::directory_entry& a,
-                 const fs::directory_entry& b) {
-                  return a.last_write_time() < b.last_write_time();
-              });
+    static bool hasMonotonicRaw()
+    {
+#if defined(__linux__)
+        return true;
+#else
+        return false;
+#endif
+    }
 
-    for (auto& f : files) {
-        if (totalSize <= config().maxLogsTotalSize)
-            break;
+    void sample(uint64_t& ticks, int64_t& wall, int64_t& steady) const
+    {
+        // 取两次 tick 的中点，夹住 system_clock 的读取时刻；跨度过大（被抢占）时重试
+        uint64_t bestSpan = UINT64_MAX;
+        for (int i = 0; i < 5; ++i) {
+            uint64_t t0 = now();
+            int64_t  w  = wallNowNs();
+            int64_t  s  = steadyNowNs();
+            uint64_t t1 = now();
+            if (t1 - t0 < bestSpan) {
+                bestSpan = t1 - t0;
+                ticks    = t0 + (t1 - t0) / 2;
+                wall     = w;
+                steady   = s;
+            }
+        }
+    }
 
-        auto p  = f.path();
-        auto sz = f.file_size();
+    std::atomic<int> mode{System};
+    bool     calibrated  = false;
+    double   nsPerTick   = 1.0;
+    uint64_t baseTicks   = 0;
+    int64_t  baseSteady  = 0;
+    uint64_t anchorTicks = 0;
+    int64_t  anchorWall  = 0;
+};
 
-        fs::remove(p);
+// 0 为尚未取得；fork 后子进程中调用 fork() 的线程由 atfork 处理清零重取
+static thread_local uint64_t t_threadId = 0;
 
-        if (totalSize >= sz) {
-            totalSize -= sz;
-        } else {
-            totalSize = 0;
-        }
+static uint64_t currentThreadId()
+{
+    if (CSLOG_UNLIKELY(!t_threadId)) {
+#if defined(__linux__)
+        t_threadId = static_cast<uint64_t>(::syscall(SYS_gettid));
+#else
+        t_threadId = static_cast<uint64_t>(std::hash<std::thread::id>{}(std::this_thread::get_id()));
+#endif
     }
+    return t_threadId;
+}
+
+static long currentProcessId()
+{
+#ifdef _WIN32
+    return static_cast<long>(_getpid());
+#else
+    return static_cast<long>(::getpid());
+#endif
 }
 
-void Logger::createNewLogFile()
+static std::string fileTimestamp()
 {
     auto now = std::chrono::system_clock::now();
     time_t t = std::chrono::system_clock::to_time_t(now);
@@ -159,216 +277,2701 @@ void Logger::createNewLogFile()
 
     char buf[64];
     std::snprintf(buf, sizeof(buf),
-        "_%04d-%02d-%02d_%02d-%02d-%02d.log",
+        "%04d-%02d-%02d_%02d-%02d-%02d",
         tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday,
         tm.tm_hour, tm.tm_min, tm.tm_sec
     );
+    return buf;
+}
 
-    currentFileName = config().logPath + config().baseName + buf;
-
-    LOG_INFO << "日志文件：" << currentFileName;
-
-    file.open(currentFileName, std::ios::binary | std::ios::app);
-    if (!file.is_open()) {
-        currentSize = 0;
+static void appendLogfmtValue(std::string& out, std::string_view s)
+{
+    bool quote = s.empty() ||
+                 s.find_first_of(" =\"\\\t\r\n") != std::string_view::npos;
+    if (!quote) {
+        out += s;
         return;
     }
+    out += '"';
+    appendJsonEscaped(out, s);
+    out += '"';
+}
 
-    if (fileBuffer.empty()) {
-        fileBuffer.resize(64 * 1024);
-    }
-    file.rdbuf()->pubsetbuf(fileBuffer.data(), fileBuffer.size());
+static void appendInt(std::string& out, uint64_t v, int width = 0)
+{
+    char buf[24];
+    int  n = std::snprintf(buf, sizeof(buf), "%0*llu", width, static_cast<unsigned long long>(v));
+    out.append(buf, static_cast<size_t>(n));
+}
 
-    file.seekp(0, std::ios::end);
-    currentSize = static_cast<size_t>(file.tellp());
-    bytesSinceFlush = 0;
+static std::string_view baseName(const char* path)
+{
+    std::string_view p(path ? path : "");
+    size_t pos = p.find_last_of("/\\");
+    return pos == std::string_view::npos ? p : p.substr(pos + 1);
 }
 
-void Logger::openFileOnce() {
-    if (file.is_open()) return;
+static void appendLevelLower(std::string& out, LogLevel lvl)
+{
+    for (const char* p = levelName(lvl); *p; ++p) {
+        out += static_cast<char>(std::tolower(static_cast<unsigned char>(*p)));
+    }
+}
 
-    std::filesystem::create_directories(config().logPath);
+const TimeParts& TimeCache::get(int64_t wallNs)
+{
+    int64_t sec  = wallNs >= 0 ? wallNs / 1000000000 : (wallNs + 1) / 1000000000 - 1;
+    parts.nsec   = wallNs - sec * 1000000000;
 
-    cleanupOldLogFiles();
+    if (sec != parts.sec || !valid) {
+        time_t t = static_cast<time_t>(sec);
+#ifdef _WIN32
+        localtime_s(&parts.tm, &t);
+#else
+        localtime_r(&t, &parts.tm);
+#endif
+        std::strftime(parts.date, sizeof(parts.date), "%Y-%m-%d", &parts.tm);
+        std::strftime(parts.time, sizeof(parts.time), "%H:%M:%S", &parts.tm);
+        parts.sec = sec;
+        valid     = true;
+    }
+    return parts;
+}
 
-    createNewLogFile();
+// Gap 记录的正文为后台线程填入的起始时刻
+static void appendGap(std::string& out, const LogTask& task)
+{
+    out += "dropped=";
+    appendInt(out, task.dropped);
+    out += " since=";
+    out += task.text;
 }
 
-void Logger::rotate()
+void formatJson(const LogTask& task, const TimeParts& tp, std::string& out)
 {
-    if (currentSize < config().maxFileSize)
-        return;
+    out += "{\"time\":\"";
+    out += tp.date;
+    out += ' ';
+    out += tp.time;
+    out += "\",\"level\":\"";
+    out += levelName(task.lvl);
+    out += "\"";
+
+    if (task.seq) {
+        out += ",\"seq\":";
+        appendInt(out, task.seq);
+    }
 
-    if (file.is_open()) {
-        file.flush();
-        file.close();
+    if (task.kind == TaskKind::Gap) {
+        out += ",\"dropped\":";
+        appendInt(out, task.dropped);
+        out += ",\"since\":\"";
+        out += task.text;
+        out += "\"}";
+        return;
     }
 
-    cleanupOldLogFiles();
+    if (task.file) {
+        out += ",\"file\":\"";
+        appendJsonEscaped(out, task.file);
+        out += "\",\"line\":";
+        appendInt(out, static_cast<uint64_t>(task.line));
+        out += ",\"func\":\"";
+        appendJsonEscaped(out, task.func ? task.func : "");
+        out += "\"";
+    }
 
-    createNewLogFile();
+    out += ",\"msg\":\"";
+    appendJsonEscaped(out, task.text);
+    out += "\"}";
 }
 
-void Logger::push(LogLevel lvl, const std::string& msg) {
-    if (!config().enable || lvl > config().level)
+void formatLogfmt(const LogTask& task, const TimeParts& tp, std::string& out)
+{
+    out += "time=";
+    out += tp.date;
+    out += 'T';
+    out += tp.time;
+    out += '.';
+    appendInt(out, static_cast<uint64_t>(tp.nsec / 1000000), 3);
+    out += " level=";
+    appendLevelLower(out, task.lvl);
+
+    if (task.seq) {
+        out += " seq=";
+        appendInt(out, task.seq);
+    }
+
+    if (task.kind == TaskKind::Gap) {
+        out += " dropped=";
+        appendInt(out, task.dropped);
+        out += " since=";
+        appendLogfmtValue(out, task.text);
         return;
+    }
 
-    std::unique_lock<std::mutex> lock(mtx);
+    if (task.file) {
+        out += " file=";
+        appendLogfmtValue(out, task.file);
+        out += " line=";
+        appendInt(out, static_cast<uint64_t>(task.line));
+        out += " func=";
+        appendLogfmtValue(out, task.func ? task.func : "");
+    }
 
-    if (queue.size() >= config().maxQueueSize) {
+    out += " msg=";
+    appendLogfmtValue(out, task.text);
+}
 
-        if (config().queuePolicy == "drop") return;
+void formatText(const LogTask& task, const TimeParts& tp, std::string& out)
+{
+    out += tp.date;
+    out += ' ';
+    out += tp.time;
+    out += '.';
+    appendInt(out, static_cast<uint64_t>(tp.nsec / 1000000), 3);
+    out += " [";
+    out += levelName(task.lvl);
+    out += "] ";
+
+    if (task.seq) {
+        out += '#';
+        appendInt(out, task.seq);
+        out += ' ';
+    }
 
-        if (config().queuePolicy == "warn") {
-            std::cerr << "\033[33m[WARN] 日志队列已满，此日志被丢弃！\033[0m\n";
-            return;
-        }
+    if (task.kind == TaskKind::Gap) {
+        appendGap(out, task);
+        return;
+    }
 
-        if (config().queuePolicy == "block") {
-            cv.wait(lock, [&] { return queue.size() < config().maxQueueSize; });
-        }
+    if (task.file) {
+        out += baseName(task.file);
+        out += ':';
+        appendInt(out, static_cast<uint64_t>(task.line));
+        out += ' ';
     }
 
-    queue.push(LogTask{lvl, msg});
-    cv.notify_one();
+    out += task.text;
 }
 
-void Logger::workerThread()
-{
-    using namespace std::chrono;
+// 布局在配置加载时编译一次：json / logfmt / text 为内置布局，
+// 其余字符串按 pattern 解析为追加操作列表，格式化时顺序执行。
+class Formatter {
+public:
+    explicit Formatter(const std::string& spec)
+    {
+        if (spec.empty() || spec == "json") { kind = Json;   return; }
+        if (spec == "logfmt")               { kind = Logfmt; return; }
+        if (spec == "text")                 { kind = Text;   return; }
 
-    const size_t FLUSH_BYTES_THRESHOLD = 32 * 1024;
-    const int    FLUSH_INTERVAL_MS     = 1000;
+        kind = Pattern;
+        compile(spec);
+    }
 
-    auto lastFlush = steady_clock::now();
+    void format(const LogTask& task, const TimeParts& tp, std::string& out) const
+    {
+        out.clear();
+        switch (kind) {
+            case Json:    formatJson(task, tp, out);    break;
+            case Logfmt:  formatLogfmt(task, tp, out);  break;
+            case Text:    formatText(task, tp, out);    break;
+            case Pattern: formatPattern(task, tp, out); break;
+        }
+        out += '\n';
+    }
 
-    while (true) {
-        LogTask task;
-        bool hasTask = false;
+private:
+    enum Kind { Json, Logfmt, Text, Pattern };
 
-        {
-            std::unique_lock<std::mutex> lock(mtx);
+    enum class Op : uint8_t {
+        Literal,
+        Year, Month, Day, Hour, Minute, Second,
+        Date, Time, Millis, Micros,
+        Level, LevelLower,
+        SourceBase, SourcePath, SourceLoc, Line, Func,
+        Message, ThreadId, ProcessId, Sequence
+    };
 
-            cv.wait_for(lock, milliseconds(FLUSH_INTERVAL_MS), [&] {
-                return exitFlag || !queue.empty();
-            });
+    struct Step {
+        Op          op;
+        std::string literal;
+    };
 
-            if (exitFlag && queue.empty()) {
-                break;
+    void compile(const std::string& spec)
+    {
+        std::string lit;
+        auto flushLiteral = [&] {
+            if (!lit.empty()) {
+                steps.push_back(Step{Op::Literal, lit});
+                lit.clear();
             }
+        };
 
-            if (!queue.empty()) {
-                task = std::move(queue.front());
-                queue.pop();
-                hasTask = true;
+        for (size_t i = 0; i < spec.size(); ++i) {
+            if (spec[i] != '%' || i + 1 == spec.size()) {
+                lit += spec[i];
+                continue;
             }
-        }
 
-        if (hasTask) {
-            if (config().toConsole) {
-                std::cout << levelColor(task.lvl)
-                          << task.text
-                          << COLOR_RESET;
-                std::cout.flush();
+            Op op;
+            switch (spec[++i]) {
+                case 'Y': op = Op::Year;       break;
+                case 'm': op = Op::Month;      break;
+                case 'd': op = Op::Day;        break;
+                case 'H': op = Op::Hour;       break;
+                case 'M': op = Op::Minute;     break;
+                case 'S': op = Op::Second;     break;
+                case 'F': op = Op::Date;       break;
+                case 'T': op = Op::Time;       break;
+                case 'e': op = Op::Millis;     break;
+                case 'f': op = Op::Micros;     break;
+                case 'L': op = Op::Level;      break;
+                case 'l': op = Op::LevelLower; break;
+                case 's': op = Op::SourceBase; break;
+                case 'g': op = Op::SourcePath; break;
+                case '@': op = Op::SourceLoc;  break;
+                case '#': op = Op::Line;       break;
+                case '!': op = Op::Func;       break;
+                case 'v': op = Op::Message;    break;
+                case 't': op = Op::ThreadId;   break;
+                case 'P': op = Op::ProcessId;  break;
+                case 'q': op = Op::Sequence;   break;
+                default:
+                    if (spec[i] != '%') lit += '%';
+                    lit += spec[i];
+                    continue;
             }
 
-            if (config().toFile) {
-                openFileOnce();
-                if (file.is_open()) {
-                    file.write(task.text.data(), task.text.size());
-                    currentSize     += task.text.size();
-                    bytesSinceFlush += task.text.size();
-                    rotate();
+            flushLiteral();
+            steps.push_back(Step{op, {}});
+        }
+        flushLiteral();
+    }
 
-                    if (task.lvl <= LOG_LEVEL_ERROR) {
-                        file.flush();
-                        bytesSinceFlush = 0;
-                        lastFlush = steady_clock::now();
+    void formatPattern(const LogTask& task, const TimeParts& tp, std::string& out) const
+    {
+        for (const Step& st : steps) {
+            switch (st.op) {
+                case Op::Literal:    out += st.literal; break;
+                case Op::Year:       appendInt(out, tp.tm.tm_year + 1900, 4); break;
+                case Op::Month:      appendInt(out, tp.tm.tm_mon + 1, 2); break;
+                case Op::Day:        appendInt(out, tp.tm.tm_mday, 2); break;
+                case Op::Hour:       appendInt(out, tp.tm.tm_hour, 2); break;
+                case Op::Minute:     appendInt(out, tp.tm.tm_min, 2); break;
+                case Op::Second:     appendInt(out, tp.tm.tm_sec, 2); break;
+                case Op::Date:       out += tp.date; break;
+                case Op::Time:       out += tp.time; break;
+                case Op::Millis:     appendInt(out, static_cast<uint64_t>(tp.nsec / 1000000), 3); break;
+                case Op::Micros:     appendInt(out, static_cast<uint64_t>(tp.nsec / 1000), 6); break;
+                case Op::Level:      out += levelName(task.lvl); break;
+                case Op::LevelLower: appendLevelLower(out, task.lvl); break;
+                case Op::SourceBase: if (task.file) out += baseName(task.file); break;
+                case Op::SourcePath: if (task.file) out += task.file; break;
+                case Op::SourceLoc:
+                    if (task.file) {
+                        out += baseName(task.file);
+                        out += ':';
+                        appendInt(out, static_cast<uint64_t>(task.line));
                     }
-                }
+                    break;
+                case Op::Line:       if (task.file) appendInt(out, static_cast<uint64_t>(task.line)); break;
+                case Op::Func:       if (task.func) out += task.func; break;
+                case Op::Message:
+                    if (task.kind == TaskKind::Gap) {
+                        appendGap(out, task);
+                    } else {
+                        out += task.text;
+                    }
+                    break;
+                case Op::ThreadId:   appendInt(out, task.tid); break;
+                case Op::ProcessId:  appendInt(out, static_cast<uint64_t>(currentProcessId())); break;
+                case Op::Sequence:   appendInt(out, task.seq); break;
             }
         }
+    }
 
-        if (config().toFile && file.is_open()) {
-            bool needFlush = false;
+    Kind              kind = Json;
+    std::vector<Step> steps;
+};
 
-            if (bytesSinceFlush >= FLUSH_BYTES_THRESHOLD) {
-                needFlush = true;
-            } else {
-                auto now = steady_clock::now();
-                if (duration_cast<milliseconds>(now - lastFlush).count() >= FLUSH_INTERVAL_MS) {
-                    needFlush = true;
-                }
-            }
+// 后台线程剖析：以 CSLOG_PROFILE_WORKER 编译时，各阶段的周期数记入无锁直方图，
+// 可由 Logger::workerProfile() 读取，stop() 时输出到 stderr；未定义时以下宏为空。
+#ifdef CSLOG_PROFILE_WORKER
+static uint64_t profileNow()
+{
+#ifdef CSLOG_HAS_RDTSC
+    return __rdtsc();
+#else
+    return static_cast<uint64_t>(steadyNowNs());
+#endif
+}
 
-            if (needFlush) {
-                file.flush();
-                bytesSinceFlush = 0;
-                lastFlush = steady_clock::now();
-            }
-        }
+struct StageScope {
+    AtomicHistogram& hist;
+    uint64_t         begin = profileNow();
 
-        {
-            std::unique_lock<std::mutex> lock(mtx);
-            cv.notify_all();
-        }
-    }
+    ~StageScope() { hist.record(profileNow() - begin); }
+};
+
+#define CSLOG_PROFILE_BEGIN(var)       const uint64_t var = profileNow()
+#define CSLOG_PROFILE_END(stage, var)  profile[static_cast<size_t>(stage)].record(profileNow() - (var))
+#define CSLOG_PROFILE_SCOPE(stage)     StageScope CSLOG_CONCAT(profileScope_, __LINE__){profile[static_cast<size_t>(stage)]}
+#else
+#define CSLOG_PROFILE_BEGIN(var)       (void)0
+#define CSLOG_PROFILE_END(stage, var)  (void)0
+#define CSLOG_PROFILE_SCOPE(stage)     (void)0
+#endif
 
-    if (config().toFile && file.is_open()) {
-        file.flush();
+const char* workerStageName(WorkerStage stage)
+{
+    switch (stage) {
+        case WorkerStage::Dequeue:    return "dequeue";
+        case WorkerStage::Console:    return "console";
+        case WorkerStage::FileBuffer: return "file_buffer";
+        case WorkerStage::FileWrite:  return "file_write";
+        case WorkerStage::Flush:      return "flush";
+        case WorkerStage::Rotate:     return "rotate";
+        case WorkerStage::CreateFile: return "create_file";
+        case WorkerStage::Cleanup:    return "cleanup";
+        default:                      return "unknown";
     }
 }
 
-void Logger::stop()
-{
+// 连续数组上的环形队列，槽位直接存放 LogTask（含内联正文）；
+// 存储由 Impl::reserveQueue() 在锁外按 maxQueueSize 预先备好，经 adopt() 换入，生产者入队不会触发扩容。
+// 只有超出上限的写入（后台线程自身的日志等）才在 push 中倍增
+class TaskRing {
+public:
+    bool   empty() const    { return count == 0; }
+    size_t size() const     { return count; }
+    size_t capacity() const { return slots.size(); }
+
+    void setLimit(size_t n) { limit = n; }
+
+    // 换入调用方准备好的存储（不小于当前条数），原存储留在 fresh 中，由调用方在锁外释放
+    void adopt(std::vector<LogTask>& fresh)
     {
-        std::lock_guard<std::mutex> lock(mtx);
-        exitFlag = true;
+        for (size_t i = 0; i < count; ++i) {
+            fresh[i] = std::move(slots[(head + i) % slots.size()]);
+        }
+        slots.swap(fresh);
+        head = 0;
     }
-    cv.notify_all();
-    if (worker.joinable()) worker.join();
-    if (file.is_open()) file.close();
-}
 
-LogLine::~LogLine()
-{
-    if (!config().enable || level > config().level)
-        return;
+    void push(LogTask&& task)
+    {
+        if (count == slots.size()) grow();
 
-    std::string msg = ss.str();
+        slots[(head + count) % slots.size()] = std::move(task);
+        ++count;
+    }
+
+    LogTask& front() { return slots[head]; }
 
-    while (!msg.empty() && (msg.back() == '\n' || msg.back() == '\r')) {
-        msg.pop_back();
+    void pop()
+    {
+        head = (head + 1) % slots.size();
+        --count;
     }
 
-    auto now = std::chrono::system_clock::now();
-    time_t t = std::chrono::system_clock::to_time_t(now);
+private:
+    void grow()
+    {
+        // 只在尚未长到 limit 时截到 limit；超过上限的写入（后台线程自身的日志等）照样倍增，
+        // 摊还下来每次 push 仍是 O(1)，不会每条都整体搬迁
+        size_t cap = slots.empty() ? 1024 : slots.size() * 2;
+        if (cap > limit && slots.size() < limit) cap = limit;
 
-    std::tm tm{};
-#ifdef _WIN32
-    localtime_s(&tm, &t);
-#else
-    localtime_r(&t, &tm);
+        std::vector<LogTask> bigger(cap);
+        adopt(bigger);
+    }
+
+    std::vector<LogTask> slots;
+    size_t               head  = 0;
+    size_t               count = 0;
+    size_t               limit = 1024;
+};
+
+struct Logger::Impl {
+    explicit Impl(Logger& owner) : owner(owner) {}
+    ~Impl();
+
+    Logger&                    owner;
+    LogConfig                  cfg;
+    std::string                pendingConfigPath;
+    bool                       levelSet     = false;  // 经 setLevel() / setMaxQueueSize() 设置过，延迟加载时保留
+    bool                       queueSizeSet = false;
+    std::unique_ptr<TickClock> tickClock;
+
+    std::mutex              mtx;
+    std::condition_variable cv;
+    TaskRing                queue;
+    bool                    exitFlag = false;
+    int64_t                 exitDeadlineNs = 0;  // stop(deadline) 的期限，0 为不限
+    bool                    workerExited = false; // 后台线程已退出主循环，不会再出队
+    size_t                  blockedWaiters = 0;   // block 策略下正在等待空位的生产者，停止时要等它们入队
+
+    // 刷新屏障：flush() 记下调用时的 queuedTotal，后台线程出队数追上后 fsync 一次，
+    // 并把 flushDone 推进到当时的 flushReq
+    std::condition_variable flushCv;
+    uint64_t                queuedTotal = 0;
+    uint64_t                poppedTotal = 0;
+    uint64_t                flushTarget = 0;
+    uint64_t                flushReq    = 0;
+    uint64_t                flushDone   = 0;
+    bool                    flushOk     = false;
+    std::atomic<uint64_t>   abandonedCount{0};
+
+    // stop(deadline) 放弃的队列区间起点（出队位置）；目标超过它的刷新屏障包含被放弃的记录，一律失败
+    uint64_t                abandonedFrom = UINT64_MAX;
+
+    // 协程前端的等待者：回调一律在后台线程上、释放 mtx 之后调用
+    struct AsyncWaiter {
+        Logger::AsyncDone done = nullptr;
+        void*             arg  = nullptr;
+        uint64_t          req    = 0;  // 刷新屏障的请求号
+        uint64_t          target = 0;  // 刷新屏障登记时的 queuedTotal
+        bool              ok     = false;
+    };
+    struct ParkedTask {
+        LogTask     task;
+        AsyncWaiter waiter;
+    };
+    std::deque<ParkedTask>   parked;        // block 策略下队列满时暂存的协程任务，按到达顺序入队
+    std::vector<AsyncWaiter> flushWaiters;
+    std::vector<AsyncWaiter> readyWaiters;      // 后台线程私有：本轮待回调的等待者
+    std::vector<AsyncWaiter> abandonedWaiters;  // 后台线程私有：stop(deadline) 放弃的暂存任务
+
+    // fork 前的静默：beforeFork() 递增 forkGen 并等后台线程写出缓冲、停在安全点（parkedGen 追上），
+    // 之后持 mtx 跨过 fork()，由 afterForkParent() / afterForkChild() 放开
+    std::condition_variable forkCv;
+    bool                    forkPending = false;
+    uint64_t                forkGen     = 0;
+    uint64_t                parkedGen   = 0;
+
+    std::FILE*    file           = nullptr;
+    size_t        currentSize    = 0;
+    std::string   currentFileName;
+
+    std::thread   worker;
+
+    // 已格式化、尚未写入文件的内容；flushFile() 一次写出，失败时未写出的部分原样转入降级缓冲
+    std::string       fileBuf;
+
+    // 降级模式：按行暂存在 degradedRing（队首最旧），到 retryAtNs 时尝试恢复，失败则加倍退避
+    std::atomic<bool>       degraded{false};
+    std::deque<std::string> degradedRing;
+    int64_t                 retryAtNs      = 0;
+    int64_t                 backoffMs      = 0;
+    int                     lastIoError    = 0;
+    uint64_t                droppedAtEntry = 0;
+
+    std::atomic<uint64_t>   ioErrorCount{0};
+    std::atomic<uint64_t>   degradedCount{0};
+    std::atomic<uint64_t>   degradedDropped{0};
+    std::atomic<uint64_t>   degradedBytes{0};
+    std::atomic<uint64_t>   emergencyDeletes{0};
+
+    std::unique_ptr<Formatter> consoleFormatter;
+    std::unique_ptr<Formatter> fileFormatter;
+    bool                       sharedFormat = true;
+    std::string                lineBuf;
+    std::string                consoleBuf;
+
+    std::ofstream traceFile;
+    bool          traceHasEvents = false;
+    bool          traceFailed    = false;   // 打开失败后不再逐条 span 重试
+
+    bool          isDefault = false;
+
+    std::string   lastFileStamp;
+    int           fileStampSeq = 0;
+
+    // 入队侧计数在 mtx 下更新；后台线程侧计数用原子量，stats() 无锁读取
+    uint64_t      enqueuedCount = 0;
+    uint64_t      droppedCount  = 0;
+    uint64_t      blockedCount  = 0;
+    uint64_t      maxDepth      = 0;
+
+    // 丢弃缺口：第一次丢弃的时刻与此后丢弃的条数，有空位时先插入一条 Gap 标记
+    uint64_t      nextSeq       = 0;
+    uint64_t      gapDropped    = 0;
+    uint64_t      gapSinceTicks = 0;
+    uint8_t       gapClockMode  = 0;
+
+    std::atomic<uint64_t> writtenCount{0};
+    std::atomic<uint64_t> bytesWritten{0};
+    std::atomic<uint64_t> rotationCount{0};
+    std::atomic<uint64_t> formatNs{0};
+    std::atomic<uint64_t> writeNs{0};
+    std::atomic<uint64_t> flushNs{0};
+    std::atomic<uint64_t> flushCount{0};
+    std::atomic<uint64_t> writtenByLevel[4] = {};
+    std::atomic<uint64_t> rotateNs{0};
+    uint64_t              blockedNs = 0;
+
+    int64_t               lastMetricsNs = 0;
+
+    void writeMetrics();
+
+    // 调用点统计只由后台线程读写；nullptr 汇总直接 push() 的记录
+    struct SiteCount {
+        uint64_t records = 0;
+        uint64_t bytes   = 0;
+    };
+    std::unordered_map<const CallSite*, SiteCount> siteCounts;
+
+    void reportCallsites(int windowSec);
+
+    // 调用点限流：未限流的调用点按本周期写出的记录数（siteRate）估算速率；
+    // 限流中的调用点按 sampleSeq 的增量计算，不受队列积压影响
+    struct Throttle {
+        uint32_t every      = 0;
+        uint32_t lastSeq    = 0;
+        uint64_t sampledOut = 0;  // 限流期间未输出的条数
+    };
+    std::unordered_map<const CallSite*, uint64_t> siteRate;
+    std::unordered_map<const CallSite*, Throttle> throttled;
+
+    void limitCallsites(int64_t elapsedMs);
+    void releaseCallsites();
+
+    // 等级限速以 GCRA 形式实现令牌桶：tat 为理论到达时间，每条记录推后 intervalNs，
+    // 超前当前时间不超过 burstNs 即放行。单个原子量、取用时顺带补充，无需定时器线程。
+    struct RateGate {
+        std::atomic<int64_t>  intervalNs{0};  // 0 为不限
+        std::atomic<int64_t>  burstNs{0};
+        std::atomic<int64_t>  tat{0};
+        std::atomic<uint64_t> dropped{0};
+    };
+    RateGate rateGates[4];
+    uint64_t rateReported[4] = {};  // 上次汇总时的 dropped，仅后台线程使用
+
+    bool takeToken(LogLevel lvl);
+    void reportRateLimited(int windowSec);
+
+    // 生产者侧采样：构造 / 流式写入 / 析构整理 / push（含 block 等待）
+    struct ProducerSamples {
+        AtomicHistogram construct;
+        AtomicHistogram stream;
+        AtomicHistogram finish;
+        AtomicHistogram push;
+    };
+    std::unique_ptr<ProducerSamples> producerSamples;
+    std::atomic<int>                 sampleEvery{0};
+
+    uint64_t beginSample();
+    void     reportProducerSamples();
+
+#ifdef CSLOG_PROFILE_WORKER
+    AtomicHistogram profile[static_cast<size_t>(WorkerStage::Count)];
+    bool            profileDumped = false;
+
+    void dumpProfile();
+#endif
+
+    void start();
+    void applyConfig();
+    void publishGate(int level, bool trace);
+    void loadDeferredConfig();
+    void reserveQueue(size_t cap);
+    void enqueue(LogTask&& task);
+    void enqueueLocked(std::unique_lock<std::mutex>& lock, LogTask&& task);
+    bool enqueueAsync(LogTask&& task, Logger::AsyncDone done, void* arg);
+    void admitParked();
+    void completeFlush(uint64_t barrier);
+    void runWaiters(std::vector<AsyncWaiter>& waiters);
+    LogTask takeGap();
+
+    // 日志器自身的诊断记录（新文件、清理、I/O 错误、各类汇总）走独立的无锁通道：
+    // 任意线程压入 Treiber 栈，后台线程整体取走后按时间顺序写出，
+    // 不进入生产者队列，也不受 queuePolicy / 限速影响，后台线程写诊断时不会等待自己。
+    struct DiagNode {
+        LogTask   task;
+        DiagNode* next = nullptr;
+    };
+    std::atomic<DiagNode*> diagHead{nullptr};
+    std::vector<LogTask>   diagPending;  // 后台线程私有，尾部为最早的一条
+
+    void diag(LogLevel lvl, std::string text);
+    void takeDiagnostics();
+
+#ifndef _WIN32
+    static std::mutex         forkMtx;
+    static std::vector<Impl*> forkImpls;
+
+    static void forkPrepare();
+    static void forkParent();
+    static void forkChild();
+    void registerForFork();
+    void unregisterForFork();
+    void beforeFork();
+    void afterForkParent();
+    void afterForkChild();
+#endif
+    bool flush(std::chrono::milliseconds timeout);
+    bool flushAsync(Logger::AsyncDone done, void* arg);
+    uint64_t stop(int64_t deadlineNs);
+
+    void workerThread();
+    void rotate();
+    void openFileOnce();
+    void flushFile(bool sync = false);
+    void closeFile();
+
+    void cleanupOldLogFiles();
+    void createNewLogFile();
+
+    std::vector<std::filesystem::directory_entry> listLogFiles();
+    void bufferDegraded(std::string_view lines, bool front);
+    void enterDegraded(const std::string& what, int err);
+    void tryResume();
+    bool emergencyDelete();
+
+    void openTraceOnce();
+    void writeSpan(const LogTask& task);
+    void closeTrace();
+};
+
+static std::string defaultConfigPath()
+{
+    const char* env = std::getenv("CSLOG_CONFIG");
+    return (env && *env) ? env : CSLOG_CONFIG_PATH;
+}
+
+#ifndef _WIN32
+// fork() 时需要静默的实例；先于 g_defaultHolder 定义，默认实例在退出时析构仍可注销。
+// 锁顺序为 g_defaultMtx → forkMtx → 各实例的 mtx
+std::mutex                 Logger::Impl::forkMtx;
+std::vector<Logger::Impl*> Logger::Impl::forkImpls;
 #endif
 
-    char tsBuf[32];
-    std::strftime(tsBuf, sizeof(tsBuf), "%Y-%m-%d %H:%M:%S", &tm);
+static std::mutex              g_defaultMtx;
+static std::unique_ptr<Logger> g_defaultHolder;
+static std::atomic<Logger*>    g_default{nullptr};
+
+std::atomic<int> Logger::defaultGate{LOG_LEVEL_DEBUG};
 
-    std::ostringstream out;
-    out << "{";
-    out << "\"time\":\"" << tsBuf << "\"";
-    out << ",\"level\":\"" << levelName(level) << "\"";
+Logger& Logger::instance() {
+    Logger* p = g_default.load(std::memory_order_acquire);
+    if (p) return *p;
 
-    if (fileName) {
-        out << ",\"file\":\""  << jsonEscape(fileName) << "\"";
-        out << ",\"line\":"    << lineNum;
-        out << ",\"func\":\""  << jsonEscape(funcName ? funcName : "") << "\"";
+    std::lock_guard<std::mutex> lock(g_defaultMtx);
+    if (!g_defaultHolder) {
+        g_defaultHolder.reset(new Logger());
+        g_default.store(g_defaultHolder.get(), std::memory_order_release);
     }
+    return *g_defaultHolder;
+}
+
+bool init(const LogConfig& config)
+{
+    std::lock_guard<std::mutex> lock(g_defaultMtx);
+    if (g_defaultHolder) return false;
+
+    g_defaultHolder.reset(new Logger(config, true));
+    g_default.store(g_defaultHolder.get(), std::memory_order_release);
+    return true;
+}
+
+bool initFromFile(const std::string& path)
+{
+    LogConfig config;
+    Logger::loadConfigFromFile(path, config);
+    return init(config);
+}
+
+Logger::Logger()
+    : impl(new Impl(*this))
+{
+    impl->isDefault         = true;
+    impl->pendingConfigPath = defaultConfigPath();
+    impl->start();
+}
+
+Logger::Logger(const LogConfig& config)
+    : Logger(config, false)
+{
+}
+
+Logger::Logger(const LogConfig& config, bool asDefault)
+    : impl(new Impl(*this))
+{
+    impl->isDefault = asDefault;
+    impl->cfg       = config;
+    impl->start();
+}
+
+Logger::~Logger() {
+    stop();
+    delete impl;
+}
+
+LogConfig& Logger::config()
+{
+    return impl->cfg;
+}
+
+#ifndef _WIN32
+void Logger::Impl::forkPrepare()
+{
+    g_defaultMtx.lock();
+    forkMtx.lock();
+    for (Impl* impl : forkImpls) impl->beforeFork();
+}
+
+void Logger::Impl::forkParent()
+{
+    for (Impl* impl : forkImpls) impl->afterForkParent();
+    forkMtx.unlock();
+    g_defaultMtx.unlock();
+}
+
+void Logger::Impl::forkChild()
+{
+    t_threadId = 0;
+    for (Impl* impl : forkImpls) impl->afterForkChild();
+    forkMtx.unlock();
+    g_defaultMtx.unlock();
+}
+
+void Logger::Impl::registerForFork()
+{
+    static std::once_flag once;
+    std::call_once(once, [] { ::pthread_atfork(forkPrepare, forkParent, forkChild); });
+
+    std::lock_guard<std::mutex> lock(forkMtx);
+    forkImpls.push_back(this);
+}
+
+void Logger::Impl::unregisterForFork()
+{
+    std::lock_guard<std::mutex> lock(forkMtx);
+    forkImpls.erase(std::remove(forkImpls.begin(), forkImpls.end(), this), forkImpls.end());
+}
+#endif
+
+void Logger::Impl::start()
+{
+    tickClock = std::make_unique<TickClock>();
+    applyConfig();
+    reserveQueue(cfg.maxQueueSize);
+
+    // 延迟加载配置期间放行所有等级与区间，由后台线程按最终配置过滤
+    if (!pendingConfigPath.empty()) {
+        publishGate(LOG_LEVEL_DEBUG, true);
+    }
+
+    worker = std::thread(&Impl::workerThread, this);
+
+#ifndef _WIN32
+    registerForFork();
+#endif
+}
+
+void Logger::Impl::applyConfig()
+{
+    tickClock->setMode(cfg.clock);
+
+    consoleFormatter = std::make_unique<Formatter>(cfg.consoleFormat);
+    fileFormatter    = std::make_unique<Formatter>(cfg.fileFormat);
+    sharedFormat     = cfg.consoleFormat == cfg.fileFormat;
+
+    queue.setLimit(cfg.maxQueueSize);
+
+    for (int i = 0; i < 4; ++i) {
+        const LevelRateLimit& rl = cfg.levelRateLimit[i];
+        const int64_t interval = rl.perSec > 0 ? std::max<int64_t>(1000000000 / rl.perSec, 1) : 0;
+        const int64_t burst    = rl.burst > 0 ? rl.burst : rl.perSec;
+        rateGates[i].burstNs.store(interval * burst, std::memory_order_relaxed);
+        rateGates[i].intervalNs.store(interval, std::memory_order_relaxed);
+    }
+
+    if (cfg.latencySampleEvery > 0 && !producerSamples) {
+        producerSamples = std::make_unique<ProducerSamples>();
+    }
+    sampleEvery.store(cfg.latencySampleEvery > 0 ? cfg.latencySampleEvery : 0, std::memory_order_release);
+
+    publishGate(cfg.enable ? cfg.level : LOG_LEVEL_OFF, cfg.enable && cfg.toTrace);
+}
+
+void Logger::Impl::publishGate(int level, bool trace)
+{
+    owner.gateLevel.store(level, std::memory_order_relaxed);
+    owner.traceOn.store(trace, std::memory_order_relaxed);
+
+    if (isDefault) {
+        Logger::defaultGate.store(level, std::memory_order_relaxed);
+    }
+}
+
+void Logger::Impl::loadDeferredConfig()
+{
+    if (pendingConfigPath.empty()) return;
+
+    // 以当前配置为底，文件只覆盖其中出现的项，init() 之后经 config() 的修改不会丢失
+    LogConfig merged;
+    bool      keepSize;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        merged   = cfg;
+        keepSize = queueSizeSet;
+    }
+    Logger::loadConfigFromFile(pendingConfigPath, merged);
+    if (!keepSize) reserveQueue(merged.maxQueueSize);
+
+    std::lock_guard<std::mutex> lock(mtx);
+    if (levelSet)     merged.level        = cfg.level;
+    if (queueSizeSet) merged.maxQueueSize = cfg.maxQueueSize;
+    cfg = merged;
+    applyConfig();
+    pendingConfigPath.clear();
+}
+
+// 在锁外分配并构造 cap 个槽位，只在锁内搬迁已入队的记录；旧存储同样在锁外释放。
+// 调大上限前先调用，生产者不会在持锁时碰上扩容
+void Logger::Impl::reserveQueue(size_t cap)
+{
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (queue.capacity() >= cap) return;
+    }
+
+    std::vector<LogTask> fresh(cap);
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (queue.capacity() >= cap || queue.size() > cap) return;
+        queue.adopt(fresh);
+    }
+}
+
+void Logger::setLevel(LogLevel lvl)
+{
+    std::lock_guard<std::mutex> lock(impl->mtx);
+    impl->cfg.level = lvl;
+    impl->levelSet  = true;
+
+    // 延迟加载期间门限保持放行，由加载完成后的 applyConfig() 发布
+    if (impl->pendingConfigPath.empty()) {
+        impl->publishGate(impl->cfg.enable ? lvl : LOG_LEVEL_OFF, impl->cfg.enable && impl->cfg.toTrace);
+    }
+}
+
+void Logger::setMaxQueueSize(size_t n)
+{
+    if (n == 0) n = 1;
+
+    impl->reserveQueue(n);
+    {
+        std::lock_guard<std::mutex> lock(impl->mtx);
+        impl->cfg.maxQueueSize = n;
+        impl->queueSizeSet     = true;
+        impl->queue.setLimit(n);
+    }
+    // 上限调大时让等待空位的生产者重新检查
+    impl->cv.notify_all();
+}
+
+LogStats Logger::stats() const
+{
+    LogStats st;
+    {
+        std::lock_guard<std::mutex> lock(impl->mtx);
+        st.enqueued      = impl->enqueuedCount;
+        st.dropped       = impl->droppedCount;
+        st.blocked       = impl->blockedCount;
+        st.blockedNs     = impl->blockedNs;
+        st.queueDepth    = impl->queue.size();
+        st.maxQueueDepth = impl->maxDepth;
+    }
+
+    st.written      = impl->writtenCount.load(std::memory_order_relaxed);
+    st.bytesWritten = impl->bytesWritten.load(std::memory_order_relaxed);
+    st.rotations    = impl->rotationCount.load(std::memory_order_relaxed);
+    st.formatNs     = impl->formatNs.load(std::memory_order_relaxed);
+    st.writeNs      = impl->writeNs.load(std::memory_order_relaxed);
+    st.flushNs      = impl->flushNs.load(std::memory_order_relaxed);
+    st.flushes      = impl->flushCount.load(std::memory_order_relaxed);
+    for (int i = 0; i < 4; ++i) {
+        st.writtenByLevel[i] = impl->writtenByLevel[i].load(std::memory_order_relaxed);
+        st.rateLimited[i]    = impl->rateGates[i].dropped.load(std::memory_order_relaxed);
+    }
+    st.rotateNs     = impl->rotateNs.load(std::memory_order_relaxed);
+
+    st.ioErrors         = impl->ioErrorCount.load(std::memory_order_relaxed);
+    st.degradedEntries  = impl->degradedCount.load(std::memory_order_relaxed);
+    st.degradedDropped  = impl->degradedDropped.load(std::memory_order_relaxed);
+    st.degradedBuffered = impl->degradedBytes.load(std::memory_order_relaxed);
+    st.emergencyDeletes = impl->emergencyDeletes.load(std::memory_order_relaxed);
+    st.degraded         = impl->degraded.load(std::memory_order_relaxed);
+    st.abandoned        = impl->abandonedCount.load(std::memory_order_relaxed);
+    return st;
+}
+
+uint64_t Logger::now(uint8_t& clockMode) const
+{
+    clockMode = impl->tickClock->currentMode();
+    return impl->tickClock->read(clockMode);
+}
+
+bool Logger::loadConfigFromFile(const std::string& path, LogConfig& cfg)
+{
+    std::error_code ec;
+    if (!std::filesystem::exists(path, ec)) return false;
+
+    YAML::Node root;
+    try {
+        root = YAML::LoadFile(path);
+    } catch (const std::exception& e) {
+        std::cerr << "\033[33m[WARN] 日志配置解析失败，使用默认配置：" << path << " (" << e.what() << ")\033[0m\n";
+        return false;
+    }
+
+    if (auto node = root["csLog"]) {
+
+        auto get = [&](const char* key, auto& dst) {
+            if (!node[key]) return;
+            try {
+                dst = node[key].as<std::decay_t<decltype(dst)>>();
+            } catch (const std::exception&) {
+                std::cerr << "\033[33m[WARN] 日志配置项无效，已忽略：" << key << "\033[0m\n";
+            }
+        };
+
+        get("enable",           cfg.enable);
+        get("toConsole",        cfg.toConsole);
+        get("toFile",           cfg.toFile);
+        get("logPath",          cfg.logPath);
+        get("fileName",         cfg.baseName);
+        get("maxFileCount",     cfg.maxFileCount);
+        get("maxFileSize",      cfg.maxFileSize);
+        get("maxLogsTotalSize", cfg.maxLogsTotalSize);
+        get("maxQueueSize",     cfg.maxQueueSize);
+        get("queuePolicy",      cfg.queuePolicy);
+        get("toTrace",          cfg.toTrace);
+        get("sequence",         cfg.sequence);
+        get("clock",            cfg.clock);
+        get("consoleFormat",    cfg.consoleFormat);
+        get("fileFormat",       cfg.fileFormat);
+        get("durability",       cfg.durability);
+        get("degradedBufferSize", cfg.degradedBufferSize);
+        get("forkChildFile",    cfg.forkChildFile);
+        get("workerTiming",     cfg.workerTiming);
+        get("latencySampleEvery", cfg.latencySampleEvery);
+        get("latencyReportSec", cfg.latencyReportSec);
+        get("metricsFile",      cfg.metricsFile);
+        get("metricsIntervalSec", cfg.metricsIntervalSec);
+        get("callsiteReportSec", cfg.callsiteReportSec);
+        get("callsiteTopN",     cfg.callsiteTopN);
+        get("callsiteRateLimit", cfg.callsiteRateLimit);
+        get("rateLimitReportSec", cfg.rateLimitReportSec);
+
+        // levelRateLimit: { info: { perSec: 50000, burst: 200000 }, debug: { perSec: 1000 } }
+        if (auto limits = node["levelRateLimit"]) {
+            const char* keys[] = {"error", "warn", "info", "debug"};
+            for (int i = 0; i < 4; ++i) {
+                auto lv = limits[keys[i]];
+                if (!lv) continue;
+                try {
+                    if (lv["perSec"]) cfg.levelRateLimit[i].perSec = lv["perSec"].as<int>();
+                    if (lv["burst"])  cfg.levelRateLimit[i].burst  = lv["burst"].as<int>();
+                } catch (const std::exception&) {
+                    std::cerr << "\033[33m[WARN] 日志配置项无效，已忽略：levelRateLimit." << keys[i] << "\033[0m\n";
+                }
+            }
+        }
+
+        if (node["level"]) {
+            std::string s = node["level"].as<std::string>();
+            std::transform(s.begin(), s.end(), s.begin(), ::toupper);
+            switch (s[0]) {
+                case 'E': cfg.level = LOG_LEVEL_ERROR; break;
+                case 'W': cfg.level = LOG_LEVEL_WARN;  break;
+                case 'I': cfg.level = LOG_LEVEL_INFO;  break;
+                case 'D': cfg.level = LOG_LEVEL_DEBUG; break;
+                default:  cfg.level = LOG_LEVEL_INFO;  break;
+            }
+        }
+    }
+
+    return true;
+}
+
+// 本实例的 .log 文件，按修改时间从旧到新；目录不可读时返回空
+std::vector<std::filesystem::directory_entry> Logger::Impl::listLogFiles()
+{
+    namespace fs = std::filesystem;
+
+    std::vector<fs::directory_entry> files;
+
+    std::string prefix = cfg.baseName + "_";
+    std::string suffix = ".log";
+
+    std::error_code ec;
+    for (fs::directory_iterator it(cfg.logPath, ec), end; !ec && it != end; it.increment(ec)) {
+        if (!it->is_regular_file(ec)) continue;
+
+        std::string name = it->path().filename().string();
+
+        if (name.rfind(prefix, 0) == 0 &&
+            name.size() > prefix.size() + suffix.size() &&
+            name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0)
+        {
+            files.push_back(*it);
+        }
+    }
+
+    std::sort(files.begin(), files.end(),
+              [](const fs::directory_entry& a,
+                 const fs::directory_entry& b) {
+                  std::error_code ea, eb;
+                  return a.last_write_time(ea) < b.last_write_time(eb);
+              });
+    return files;
+}
+
+void Logger::Impl::cleanupOldLogFiles()
+{
+    CSLOG_PROFILE_SCOPE(WorkerStage::Cleanup);
+
+    namespace fs = std::filesystem;
+
+    if (cfg.maxLogsTotalSize == 0) return;
+
+    std::vector<fs::directory_entry> files = listLogFiles();
+
+    if (files.empty()) return;
+
+    std::uintmax_t totalSize = 0;
+    for (auto& f : files) {
+        std::error_code ec;
+        auto sz = f.file_size(ec);
+        if (!ec) totalSize += sz;
+    }
+
+    if (totalSize <= cfg.maxLogsTotalSize)
+        return;
+
+    for (auto& f : files) {
+        if (totalSize <= cfg.maxLogsTotalSize)
+            break;
+
+        std::error_code ec;
+        auto p  = f.path();
+        auto sz = f.file_size(ec);
+        if (ec) sz = 0;
+
+        if (!fs::remove(p, ec)) {
+            diag(LOG_LEVEL_ERROR, "删除旧日志文件失败：" + p.string() + " (" + ec.message() + ")");
+            continue;
+        }
+        diag(LOG_LEVEL_INFO, "删除旧日志文件：" + p.string() + "（" + std::to_string(sz) + " 字节）");
+
+        if (totalSize >= sz) {
+            totalSize -= sz;
+        } else {
+            totalSize = 0;
+        }
+    }
+}
+
+void Logger::Impl::createNewLogFile()
+{
+    CSLOG_PROFILE_SCOPE(WorkerStage::CreateFile);
+
+    // 同一秒内多次滚动时追加序号，避免重新打开刚写满的文件
+    std::string stamp = fileTimestamp();
+    if (stamp == lastFileStamp) {
+        stamp += "_" + std::to_string(++fileStampSeq);
+    } else {
+        lastFileStamp = stamp;
+        fileStampSeq  = 0;
+    }
+
+    // 调用方应已关闭旧文件；仍打开时先关掉，不让新句柄覆盖旧句柄（关闭时写出失败则留给 tryResume()）
+    if (file) {
+        closeFile();
+        if (degraded.load(std::memory_order_relaxed)) return;
+    }
+
+    currentFileName = cfg.logPath + cfg.baseName + "_" + stamp + ".log";
+
+    file = std::fopen(currentFileName.c_str(), "ab");
+    if (!file) {
+        currentSize = 0;
+        enterDegraded("无法创建日志文件：" + currentFileName, errno);
+        return;
+    }
+
+    diag(LOG_LEVEL_INFO, "日志文件：" + currentFileName);
+
+    // 缓冲由 fileBuf 承担，stdio 不再另做一层，写失败时能确切知道哪些内容没有落盘
+    std::setvbuf(file, nullptr, _IONBF, 0);
+    fileBuf.reserve(64 * 1024);
+
+    std::fseek(file, 0, SEEK_END);
+    long pos = std::ftell(file);
+    currentSize = pos > 0 ? static_cast<size_t>(pos) : 0;
+}
+
+static void truncateFile(std::FILE* fp, uint64_t size)
+{
+#ifdef _WIN32
+    _chsize_s(_fileno(fp), static_cast<__int64>(size));
+#else
+    (void)!::ftruncate(::fileno(fp), static_cast<off_t>(size));
+#endif
+}
+
+void Logger::Impl::flushFile(bool sync)
+{
+    if (!file) return;
+
+    CSLOG_PROFILE_SCOPE(WorkerStage::Flush);
+
+    const int64_t flushBegin = steadyNowNs();
+
+    if (!fileBuf.empty()) {
+        CSLOG_PROFILE_BEGIN(writeBegin);
+        const size_t n  = std::fwrite(fileBuf.data(), 1, fileBuf.size(), file);
+        const bool   ok = n == fileBuf.size() && std::fflush(file) == 0;
+        CSLOG_PROFILE_END(WorkerStage::FileWrite, writeBegin);
+        if (!ok) {
+            const int err = errno;
+
+            // 截掉写了一半的行，整行留到恢复后补写，两边文件都保持按行完整
+            size_t keep = n;
+            while (keep > 0 && fileBuf[keep - 1] != '\n') --keep;
+            if (keep != n) {
+                truncateFile(file, currentSize - fileBuf.size() + keep);
+            }
+            fileBuf.erase(0, keep);
+
+            enterDegraded("写入日志文件失败：" + currentFileName, err);
+            return;
+        }
+        fileBuf.clear();
+    }
+
+    if (sync || cfg.durability == "fsync") {
+#ifdef _WIN32
+        const int rc = _commit(_fileno(file));
+#else
+        const int rc = ::fsync(::fileno(file));
+#endif
+        if (rc != 0) {
+            enterDegraded("fsync 日志文件失败：" + currentFileName, errno);
+            return;
+        }
+    }
+
+    flushCount.fetch_add(1, std::memory_order_relaxed);
+    flushNs.fetch_add(static_cast<uint64_t>(steadyNowNs() - flushBegin), std::memory_order_relaxed);
+}
+
+void Logger::Impl::closeFile()
+{
+    if (!file) return;
+
+    flushFile();
+    if (file) {
+        std::fclose(file);
+        file = nullptr;
+    }
+}
+
+void Logger::Impl::openFileOnce() {
+    if (file || degraded.load(std::memory_order_relaxed)) return;
+
+    std::error_code ec;
+    std::filesystem::create_directories(cfg.logPath, ec);
+
+    cleanupOldLogFiles();
+
+    createNewLogFile();
+}
+
+void Logger::Impl::rotate()
+{
+    if (currentSize < cfg.maxFileSize)
+        return;
+
+    int64_t start = cfg.workerTiming ? steadyNowNs() : 0;
+    CSLOG_PROFILE_SCOPE(WorkerStage::Rotate);
+
+    closeFile();
+
+    // 关闭前的最后一次写出失败时已转入降级模式，新文件交给 tryResume() 去开
+    if (degraded.load(std::memory_order_relaxed)) return;
+
+    cleanupOldLogFiles();
+
+    createNewLogFile();
+
+    rotationCount.fetch_add(1, std::memory_order_relaxed);
+    if (cfg.workerTiming) {
+        rotateNs.fetch_add(static_cast<uint64_t>(steadyNowNs() - start), std::memory_order_relaxed);
+    }
+}
+
+// 按行存入降级缓冲；front 为 true 时放在队首（比缓冲中已有的更早）。超出上限时丢弃最旧的行。
+void Logger::Impl::bufferDegraded(std::string_view lines, bool front)
+{
+    std::vector<std::string> split;
+    while (!lines.empty()) {
+        size_t nl  = lines.find('\n');
+        size_t len = nl == std::string_view::npos ? lines.size() : nl + 1;
+        split.emplace_back(lines.substr(0, len));
+        lines.remove_prefix(len);
+    }
+
+    uint64_t bytes = degradedBytes.load(std::memory_order_relaxed);
+    for (const auto& l : split) bytes += l.size();
+
+    if (front) {
+        degradedRing.insert(degradedRing.begin(), std::make_move_iterator(split.begin()), std::make_move_iterator(split.end()));
+    } else {
+        for (auto& l : split) degradedRing.push_back(std::move(l));
+    }
+
+    while (bytes > cfg.degradedBufferSize && !degradedRing.empty()) {
+        bytes -= degradedRing.front().size();
+        degradedRing.pop_front();
+        degradedDropped.fetch_add(1, std::memory_order_relaxed);
+    }
+    degradedBytes.store(bytes, std::memory_order_relaxed);
+}
+
+// 关闭出错的文件，未写出的内容转入降级缓冲；已在降级模式时只加倍退避
+void Logger::Impl::enterDegraded(const std::string& what, int err)
+{
+    ioErrorCount.fetch_add(1, std::memory_order_relaxed);
+    lastIoError = err;
+
+    bufferDegraded(fileBuf, true);
+    fileBuf.clear();
+
+    // 出错的文件若一字未写则删掉，不留空文件
+    if (file) {
+        std::fclose(file);
+        file = nullptr;
+
+        std::error_code ec;
+        if (std::filesystem::file_size(currentFileName, ec) == 0 && !ec) {
+            std::filesystem::remove(currentFileName, ec);
+        }
+    }
+
+    if (!degraded.load(std::memory_order_relaxed)) {
+        degraded.store(true, std::memory_order_relaxed);
+        degradedCount.fetch_add(1, std::memory_order_relaxed);
+        droppedAtEntry = degradedDropped.load(std::memory_order_relaxed);
+        backoffMs = 100;
+
+        // 降级期间提示本身也可能被挤出缓冲，另写一份到 stderr
+        std::string msg = what + " (" + std::strerror(err) + ")，进入降级模式，记录暂存内存（上限 " +
+                          std::to_string(cfg.degradedBufferSize) + " 字节）";
+        std::cerr << "\033[31m[ERROR] " << msg << "\033[0m\n";
+        diag(LOG_LEVEL_ERROR, std::move(msg));
+    } else {
+        backoffMs = std::min<int64_t>(backoffMs * 2, 30000);
+    }
+    retryAtNs = steadyNowNs() + backoffMs * 1000000;
+}
+
+// 磁盘写满时删除最旧的一个日志文件；出错的当前文件是最新的，不在其列
+bool Logger::Impl::emergencyDelete()
+{
+    auto files = listLogFiles();
+    if (files.size() <= 1) return false;
+
+    std::error_code ec;
+    const auto& victim = files.front();
+    auto sz = victim.file_size(ec);
+    if (!std::filesystem::remove(victim.path(), ec)) return false;
+
+    emergencyDeletes.fetch_add(1, std::memory_order_relaxed);
+    diag(LOG_LEVEL_WARN, "磁盘已满，紧急删除最旧日志文件：" + victim.path().string() +
+                         "（" + std::to_string(ec ? 0 : sz) + " 字节）");
+    return true;
+}
+
+void Logger::Impl::tryResume()
+{
+#ifdef EDQUOT
+    if (lastIoError == ENOSPC || lastIoError == EDQUOT) emergencyDelete();
+#else
+    if (lastIoError == ENOSPC) emergencyDelete();
+#endif
+
+    std::error_code ec;
+    std::filesystem::create_directories(cfg.logPath, ec);
+
+    // 已有打开的文件时沿用，不再另开一个
+    if (!file) createNewLogFile();
+    if (!file) return;
+
+    // 补写期间失败时 enterDegraded 会把 fileBuf 放回缓冲队首，顺序不变
+    size_t lines = 0;
+    while (!degradedRing.empty()) {
+        fileBuf     += degradedRing.front();
+        currentSize += degradedRing.front().size();
+        degradedBytes.fetch_sub(degradedRing.front().size(), std::memory_order_relaxed);
+        degradedRing.pop_front();
+        ++lines;
+
+        if (fileBuf.size() >= 64 * 1024) {
+            flushFile();
+            if (!file) return;
+        }
+    }
+    flushFile();
+    if (!file) return;
+
+    degraded.store(false, std::memory_order_relaxed);
+    diag(LOG_LEVEL_INFO, "日志文件恢复写入：" + currentFileName + "，补写 " + std::to_string(lines) +
+                         " 行，降级期间丢弃最旧的 " +
+                         std::to_string(degradedDropped.load(std::memory_order_relaxed) - droppedAtEntry) + " 行");
+}
+
+void Logger::Impl::openTraceOnce()
+{
+    if (traceFile.is_open() || traceFailed) return;
+
+    // 在后台线程上执行，不能让文件系统异常逃出去
+    std::error_code ec;
+    std::filesystem::create_directories(cfg.logPath, ec);
+
+    std::string name = cfg.logPath + cfg.baseName + "_" + fileTimestamp() + ".trace.json";
+    traceFile.open(name, std::ios::binary | std::ios::trunc);
+    if (!traceFile.is_open()) {
+        traceFailed = true;
+        diag(LOG_LEVEL_ERROR, "无法创建 trace 文件：" + name +
+                              (ec ? " (" + ec.message() + ")" : std::string()) + "，本次运行不再记录 span");
+        return;
+    }
+
+    traceFile << "[\n";
+    traceHasEvents = false;
+}
+
+void Logger::Impl::writeSpan(const LogTask& task)
+{
+    openTraceOnce();
+    if (!traceFile.is_open()) return;
+
+    int64_t beginNs = tickClock->toWallNs(task.ticks, task.clockMode);
+    int64_t durNs   = tickClock->toNs(task.endTicks, task.clockMode) - tickClock->toNs(task.ticks, task.clockMode);
+    if (beginNs < 0) beginNs = 0;
+    if (durNs   < 0) durNs   = 0;
+
+    char buf[160];
+    std::snprintf(buf, sizeof(buf),
+        "\",\"cat\":\"cslog\",\"ph\":\"X\",\"ts\":%llu.%03u,\"dur\":%llu.%03u,\"pid\":%ld,\"tid\":%llu}",
+        static_cast<unsigned long long>(beginNs / 1000),
+        static_cast<unsigned>(beginNs % 1000),
+        static_cast<unsigned long long>(durNs / 1000),
+        static_cast<unsigned>(durNs % 1000),
+        currentProcessId(),
+        static_cast<unsigned long long>(task.tid));
+
+    traceFile << (traceHasEvents ? ",\n" : "")
+              << "{\"name\":\"" << jsonEscape(task.spanName ? task.spanName : "") << buf;
+    traceHasEvents = true;
+}
+
+void Logger::Impl::closeTrace()
+{
+    if (!traceFile.is_open()) return;
+
+    traceFile << "\n]\n";
+    traceFile.close();
+}
+
+// 被限流的调用点按 sampleEvery 放行；未限流时只有一次 relaxed 读
+static bool callsiteSampledOut(const CallSite* site)
+{
+    uint32_t every = site->sampleEvery.load(std::memory_order_relaxed);
+    if (every <= 1) return false;
+
+    return site->sampleSeq.fetch_add(1, std::memory_order_relaxed) % every != 0;
+}
+
+void Logger::push(LogLevel lvl, const std::string& msg) {
+    if (!enabled(lvl))
+        return;
+
+    push(lvl, std::string(msg));
+}
+
+void Logger::push(LogLevel lvl, std::string&& msg) {
+    if (!enabled(lvl))
+        return;
+
+    LogTask task;
+    task.lvl   = lvl;
+    task.text  = std::move(msg);
+    task.ticks = now(task.clockMode);
+    task.tid   = currentThreadId();
+
+    push(std::move(task));
+}
+
+void Logger::push(LogTask&& task)
+{
+    if (!enabled(task.lvl))
+        return;
+
+    impl->enqueue(std::move(task));
+}
+
+void Logger::pushLazy(LogLevel lvl, std::unique_ptr<LazyText> text, bool onWorker, const CallSite* site)
+{
+    if (!enabled(lvl) || !text)
+        return;
+
+    if ((site && callsiteSampledOut(site)) || !impl->takeToken(lvl))
+        return;
+
+    LogTask task;
+    task.lvl   = lvl;
+    task.ticks = now(task.clockMode);
+    task.tid   = currentThreadId();
+    task.site  = site;
+
+    if (onWorker) {
+        task.lazy = std::move(text);
+    } else {
+        text->render(task.text);
+    }
+
+    impl->enqueue(std::move(task));
+}
+
+void Logger::pushLazy(LogLevel lvl, LazyRender render, void* fn, const CallSite* site)
+{
+    if (!enabled(lvl) || !render)
+        return;
+
+    if ((site && callsiteSampledOut(site)) || !impl->takeToken(lvl))
+        return;
+
+    LogTask task;
+    task.lvl   = lvl;
+    task.ticks = now(task.clockMode);
+    task.tid   = currentThreadId();
+    task.site  = site;
+    render(task.text, fn);
+
+    impl->enqueue(std::move(task));
+}
+
+void Logger::pushSpan(const char* name, uint64_t beginTicks, uint64_t endTicks, uint8_t clockMode)
+{
+    if (!traceOn.load(std::memory_order_relaxed))
+        return;
+
+    LogTask task;
+    task.kind     = TaskKind::Span;
+    task.spanName = name;
+    task.ticks    = beginTicks;
+    task.endTicks = endTicks;
+    task.clockMode = clockMode;
+    task.tid      = currentThreadId();
+
+    impl->enqueue(std::move(task));
+}
+
+void Logger::Impl::diag(LogLevel lvl, std::string text)
+{
+    auto* node = new DiagNode;
+    node->task.lvl   = lvl;
+    node->task.text  = std::move(text);
+    node->task.ticks = owner.now(node->task.clockMode);
+    node->task.tid   = currentThreadId();
+
+    node->next = diagHead.load(std::memory_order_relaxed);
+    while (!diagHead.compare_exchange_weak(node->next, node, std::memory_order_release, std::memory_order_relaxed)) {
+    }
+
+    // 后台线程可能已检查过 diagHead、尚未进入等待；经 mtx 同步一次，保证这次唤醒不会丢失。
+    // 后台线程以外的调用方都不持有 mtx（目前只有 fork 后的子进程，已先解锁）
+    if (std::this_thread::get_id() != worker.get_id()) {
+        { std::lock_guard<std::mutex> lock(mtx); }
+        cv.notify_one();
+    }
+}
+
+// 栈为后进先出，依次追加后从 diagPending 尾部取出即为先进先出
+void Logger::Impl::takeDiagnostics()
+{
+    DiagNode* n = diagHead.exchange(nullptr, std::memory_order_acquire);
+    while (n) {
+        DiagNode* next = n->next;
+        diagPending.push_back(std::move(n->task));
+        delete n;
+        n = next;
+    }
+}
+
+Logger::Impl::~Impl()
+{
+#ifndef _WIN32
+    unregisterForFork();
+#endif
+    takeDiagnostics();
+}
+
+#ifndef _WIN32
+void Logger::Impl::beforeFork()
+{
+    std::unique_lock<std::mutex> lock(mtx);
+
+    if (!exitFlag && worker.joinable() && std::this_thread::get_id() != worker.get_id()) {
+        const uint64_t gen = ++forkGen;
+        forkPending = true;
+        cv.notify_all();
+        forkCv.wait(lock, [&] { return parkedGen == gen || exitFlag; });
+    }
+
+    // 持锁跨过 fork()：子进程里不会有生产者停在入队中途
+    lock.release();
+}
+
+void Logger::Impl::afterForkParent()
+{
+    forkPending = false;
+    mtx.unlock();
+    cv.notify_all();
+}
+
+// 子进程中只剩调用 fork() 的线程：后台线程与等在条件变量上的线程都不存在
+void Logger::Impl::afterForkChild()
+{
+    forkPending = false;
+    forkGen = parkedGen = 0;
+    blockedWaiters = 0;   // 父进程中等待空位的生产者不在子进程里
+
+    // 条件变量里记着父进程的等待者，按初始状态重建；线程句柄指向父进程的线程，只覆盖不析构
+    new (&cv) std::condition_variable();
+    new (&flushCv) std::condition_variable();
+    new (&forkCv) std::condition_variable();
+    new (&worker) std::thread();
+
+    // 已入队、暂存与诊断中的记录都由父进程写出
+    while (!queue.empty()) queue.pop();
+    parked.clear();
+    flushWaiters.clear();
+    gapDropped  = 0;
+    queuedTotal = poppedTotal = 0;
+    flushTarget = flushReq = flushDone = 0;
+    diagPending.clear();
+    takeDiagnostics();
+    diagPending.clear();
+
+    degradedRing.clear();
+    degradedBytes.store(0, std::memory_order_relaxed);
+
+    // trace 文件按进程各写一份
+    if (traceFile.is_open()) traceFile.close();
+
+    if (exitFlag) {
+        workerExited = true;
+        mtx.unlock();
+        return;
+    }
+
+    if (cfg.forkChildFile && cfg.toFile) {
+        if (file) {
+            std::fclose(file);
+            file = nullptr;
+        }
+        cfg.baseName += "-" + std::to_string(currentProcessId());
+        lastFileStamp.clear();
+        fileStampSeq = 0;
+    }
+
+    mtx.unlock();
+
+    diag(LOG_LEVEL_INFO, "fork 后在子进程 " + std::to_string(currentProcessId()) + " 中重启后台线程");
+    worker = std::thread(&Impl::workerThread, this);
+}
+#endif
+
+void Logger::Impl::enqueue(LogTask&& task)
+{
+    std::unique_lock<std::mutex> lock(mtx);
+    enqueueLocked(lock, std::move(task));
+}
+
+void Logger::Impl::enqueueLocked(std::unique_lock<std::mutex>& lock, LogTask&& task)
+{
+    // 序号在入队或丢弃的那一刻于 mtx 下分配，block 策略等待过的记录也不会排到后来者之后；
+    // 被丢弃的记录同样占用序号，输出中的序号缺口即丢失位置
+    const bool numbered = cfg.sequence && task.kind == TaskKind::Record;
+
+    // 有未输出的缺口时为 Gap 标记预留一个位置
+    if (queue.size() + (gapDropped ? 1 : 0) >= cfg.maxQueueSize) {
+
+        if (cfg.queuePolicy == "drop" || cfg.queuePolicy == "warn") {
+            if (numbered) ++nextSeq;
+            ++droppedCount;
+            if (gapDropped++ == 0) {
+                gapClockMode  = tickClock->currentMode();
+                gapSinceTicks = tickClock->read(gapClockMode);
+                // warn 策略每个缺口只提示一次，丢弃条数由 Gap 记录给出
+                if (cfg.queuePolicy == "warn") {
+                    std::cerr << "\033[33m[WARN] 日志队列已满，开始丢弃日志\033[0m\n";
+                }
+            }
+            return;
+        }
+
+        // 在后台线程上写的日志（如 _LAZY_ASYNC 的可调用对象内部）不能等待自己腾出空间
+        if (cfg.queuePolicy == "block" && std::this_thread::get_id() != worker.get_id()) {
+            ++blockedCount;
+            const int64_t start = steadyNowNs();
+            auto giveUp = [&] {
+                return workerExited || (exitDeadlineNs && steadyNowNs() >= exitDeadlineNs);
+            };
+            ++blockedWaiters;
+            cv.wait(lock, [&] { return queue.size() < cfg.maxQueueSize || giveUp(); });
+            --blockedWaiters;
+            blockedNs += static_cast<uint64_t>(steadyNowNs() - start);
+
+            // 普通 stop() 时后台线程会排空队列，继续等空位；只有后台线程已退出或 stop(deadline) 到期时
+            // 才不会再有空位（到期后腾出的位置也只会被放弃），记为丢弃而不是永远等下去
+            if (giveUp()) {
+                if (numbered) ++nextSeq;
+                ++droppedCount;
+                return;
+            }
+        }
+    }
+
+    if (gapDropped) {
+        queue.push(takeGap());
+        ++queuedTotal;
+    }
+
+    if (numbered) task.seq = ++nextSeq;
+    queue.push(std::move(task));
+    ++queuedTotal;
+    ++enqueuedCount;
+    if (queue.size() > maxDepth) maxDepth = queue.size();
+    cv.notify_one();
+}
+
+bool Logger::Impl::enqueueAsync(LogTask&& task, Logger::AsyncDone done, void* arg)
+{
+    std::unique_lock<std::mutex> lock(mtx);
+
+    // 已有协程在排队时新来的也排到后面，保持先来先入队
+    const bool full = queue.size() >= cfg.maxQueueSize || !parked.empty();
+    if (cfg.queuePolicy != "block" || !full || exitFlag ||
+        std::this_thread::get_id() == worker.get_id()) {
+        enqueueLocked(lock, std::move(task));
+        return true;
+    }
+
+    // 序号留到 admitParked() 真正入队时分配
+    ++blockedCount;
+
+    ParkedTask p;
+    p.task        = std::move(task);
+    p.waiter.done = done;
+    p.waiter.arg  = arg;
+    parked.push_back(std::move(p));
+    return false;
+}
+
+// 在 mtx 下由后台线程调用：把暂存的协程任务按顺序移入队列，等待者留到释放锁后回调
+void Logger::Impl::admitParked()
+{
+    while (!parked.empty() && queue.size() < cfg.maxQueueSize) {
+        LogTask& task = parked.front().task;
+        if (cfg.sequence && task.kind == TaskKind::Record) task.seq = ++nextSeq;
+        queue.push(std::move(task));
+        ++queuedTotal;
+        ++enqueuedCount;
+        readyWaiters.push_back(parked.front().waiter);
+        readyWaiters.back().ok = true;
+        parked.pop_front();
+    }
+    if (queue.size() > maxDepth) maxDepth = queue.size();
+}
+
+// 在 mtx 下调用：推进刷新屏障，取出已满足的异步等待者
+void Logger::Impl::completeFlush(uint64_t barrier)
+{
+    flushDone = barrier;
+    flushOk   = !degraded.load(std::memory_order_relaxed);
+    flushCv.notify_all();
+
+    // 结果按各自的目标判断：目标覆盖到被放弃的记录时失败，同 flush()
+    auto it = std::partition(flushWaiters.begin(), flushWaiters.end(),
+                             [&](const AsyncWaiter& w) { return w.req > barrier; });
+    for (auto w = it; w != flushWaiters.end(); ++w) {
+        w->ok = flushOk && w->target <= abandonedFrom;
+        readyWaiters.push_back(*w);
+    }
+    flushWaiters.erase(it, flushWaiters.end());
+}
+
+void Logger::Impl::runWaiters(std::vector<AsyncWaiter>& waiters)
+{
+    for (const AsyncWaiter& w : waiters) {
+        w.done(w.arg, w.ok);
+    }
+    waiters.clear();
+}
+
+// 在 mtx 下调用：生成当前缺口的 Gap 标记并清零
+LogTask Logger::Impl::takeGap()
+{
+    LogTask gap;
+    gap.kind      = TaskKind::Gap;
+    gap.lvl       = LOG_LEVEL_WARN;
+    gap.clockMode = gapClockMode;
+    gap.ticks     = tickClock->read(gapClockMode);
+    gap.endTicks  = gapSinceTicks;
+    gap.dropped   = gapDropped;
+    gapDropped    = 0;
+    return gap;
+}
+
+void Logger::Impl::workerThread()
+{
+    using namespace std::chrono;
+
+    const size_t FLUSH_BYTES_THRESHOLD = 32 * 1024;
+    const int    FLUSH_INTERVAL_MS     = 1000;
+
+    const int    CALIBRATE_INTERVAL_MS = 1000;
+
+    auto lastFlush      = steady_clock::now();
+    auto lastTraceFlush = lastFlush;
+    auto lastCalibrate  = lastFlush;
+
+    loadDeferredConfig();
+
+    TimeCache timeCache;
+
+    const bool flushEachRecord = cfg.durability != "batch";
+    const bool timing          = cfg.workerTiming;
+
+    const int  REPORT_INTERVAL_MS = (cfg.latencyReportSec > 0 ? cfg.latencyReportSec : 60) * 1000;
+    auto       lastReport         = steady_clock::now();
+
+    const bool countSites     = cfg.callsiteReportSec > 0;
+    auto       lastSiteReport = steady_clock::now();
+
+    const bool limitSites     = cfg.callsiteRateLimit > 0;
+    auto       lastSiteLimit  = steady_clock::now();
+
+    const int  RATE_REPORT_SEC = cfg.rateLimitReportSec > 0 ? cfg.rateLimitReportSec : 10;
+    auto       lastRateReport  = steady_clock::now();
+
+    // 停止时最后一个未满的窗口也要汇总；汇总产生的诊断记录由随后一轮循环写出后才真正退出
+    bool finalReported = false;
+    auto windowSec = [](steady_clock::time_point since) {
+        auto ms = duration_cast<milliseconds>(steady_clock::now() - since).count();
+        return static_cast<int>(std::max<int64_t>((ms + 999) / 1000, 1));
+    };
+
+    // 把自上次打点以来的耗时计入 acc
+    int64_t mark = 0;
+    auto lap = [&](std::atomic<uint64_t>& acc) {
+        if (!timing) return;
+        int64_t t = steadyNowNs();
+        acc.fetch_add(static_cast<uint64_t>(t - mark), std::memory_order_relaxed);
+        mark = t;
+    };
+
+    tickClock->calibrate();
+
+    while (true) {
+        LogTask task;
+        bool hasTask = false;
+        uint64_t barrier = 0;  // 非 0 时本轮末尾完成到该请求号为止的刷新屏障
+        int      filterLevel = LOG_LEVEL_DEBUG;  // 在 mtx 下取，setLevel() 可能同时修改
+        bool     finalReport = false;
+        bool     isDiag      = false;  // 日志库自身的诊断记录，不计入调用点统计
+
+        {
+            // 剖析的出队耗时 = 取锁 + 取出任务，不含空闲等待
+            CSLOG_PROFILE_BEGIN(lockBegin);
+            std::unique_lock<std::mutex> lock(mtx);
+            CSLOG_PROFILE_BEGIN(lockEnd);
+
+            cv.wait_for(lock, milliseconds(FLUSH_INTERVAL_MS), [&] {
+                return (exitFlag && !blockedWaiters) || forkPending || !queue.empty() || gapDropped || flushReq > flushDone ||
+                       !diagPending.empty() || diagHead.load(std::memory_order_relaxed);
+            });
+
+            // 即将 fork：先写出文件与 trace 缓冲，子进程继承到的缓冲为空，不会重复写出
+            if (forkPending) {
+                lock.unlock();
+                flushFile();
+                if (traceFile.is_open()) traceFile.flush();
+                lock.lock();
+
+                while (forkPending) {
+                    parkedGen = forkGen;
+                    forkCv.notify_all();
+                    cv.wait(lock);
+                }
+                continue;
+            }
+
+            // stop(deadline) 到期：丢下队列中剩余的记录，唤醒仍在等待空位的生产者
+            if (exitFlag && exitDeadlineNs && (!queue.empty() || !parked.empty()) &&
+                steadyNowNs() >= exitDeadlineNs) {
+                const size_t left = queue.size() + parked.size();
+                while (!queue.empty()) queue.pop();
+                if (abandonedFrom == UINT64_MAX) abandonedFrom = poppedTotal;
+                poppedTotal += left - parked.size();
+                for (ParkedTask& p : parked) {
+                    abandonedWaiters.push_back(p.waiter);
+                    abandonedWaiters.back().ok = false;
+                }
+                parked.clear();
+                abandonedCount.fetch_add(left, std::memory_order_relaxed);
+                diag(LOG_LEVEL_WARN, "停止期限已到，放弃 " + std::to_string(left) + " 条未写出的记录");
+                cv.notify_all();
+            }
+
+            // 诊断记录优先写出
+            if (diagPending.empty()) {
+                takeDiagnostics();
+            }
+
+            if (!diagPending.empty()) {
+                task = std::move(diagPending.back());
+                diagPending.pop_back();
+                hasTask = true;
+                isDiag  = true;
+            } else if (exitFlag && queue.empty() && parked.empty() && !gapDropped && !blockedWaiters) {
+                if (!finalReported) {
+                    finalReported = true;
+                    finalReport   = true;
+                } else {
+                    workerExited = true;
+                    cv.notify_all();
+                    break;
+                }
+            } else if (queue.empty() && gapDropped) {
+                // 队列已排空而缺口之后没有新记录入队时，由后台线程补上标记
+                task    = takeGap();
+                hasTask = true;
+            } else if (!queue.empty()) {
+                CSLOG_PROFILE_BEGIN(popBegin);
+                task = std::move(queue.front());
+                queue.pop();
+                ++poppedTotal;
+                hasTask = true;
+#ifdef CSLOG_PROFILE_WORKER
+                profile[static_cast<size_t>(WorkerStage::Dequeue)].record(
+                    (lockEnd - lockBegin) + (profileNow() - popBegin));
+#endif
+            }
+
+            if (flushReq > flushDone && poppedTotal >= flushTarget) {
+                barrier = flushReq;
+            }
+            filterLevel = cfg.level;
+        }
+
+        if (finalReport) {
+            if (producerSamples) reportProducerSamples();
+            if (countSites) reportCallsites(windowSec(lastSiteReport));
+            reportRateLimited(windowSec(lastRateReport));
+            continue;
+        }
+
+        // 缺口标记不受等级过滤
+        if (hasTask && (!cfg.enable ||
+                        (task.kind == TaskKind::Span ? !cfg.toTrace
+                                                     : task.kind == TaskKind::Record && task.lvl > filterLevel))) {
+            hasTask = false;
+        }
+
+        if (hasTask && task.kind == TaskKind::Span) {
+            writeSpan(task);
+        } else if (hasTask) {
+            if (task.lazy) {
+                task.lazy->render(task.text);
+                task.lazy.reset();
+            }
+
+            if (task.kind == TaskKind::Gap) {
+                const TimeParts& since = timeCache.get(tickClock->toWallNs(task.endTicks, task.clockMode));
+                std::string text = std::string(since.date) + ' ' + since.time + '.';
+                appendInt(text, static_cast<uint64_t>(since.nsec / 1000000), 3);
+                task.text = std::move(text);
+            }
+
+            if (timing) mark = steadyNowNs();
+
+            const TimeParts& tp = timeCache.get(tickClock->toWallNs(task.ticks, task.clockMode));
+
+            const std::string* consoleText = &lineBuf;
+            if (cfg.toFile) {
+                fileFormatter->format(task, tp, lineBuf);
+            }
+            if (cfg.toConsole && (!cfg.toFile || !sharedFormat)) {
+                consoleFormatter->format(task, tp, consoleBuf);
+                consoleText = &consoleBuf;
+            }
+            lap(formatNs);
+
+            if (cfg.toConsole) {
+                CSLOG_PROFILE_BEGIN(consoleBegin);
+                std::cout << levelColor(task.lvl)
+                          << *consoleText
+                          << COLOR_RESET;
+                std::cout.flush();
+                CSLOG_PROFILE_END(WorkerStage::Console, consoleBegin);
+            }
+
+            if (cfg.toFile) {
+                openFileOnce();
+                if (degraded.load(std::memory_order_relaxed)) {
+                    bufferDegraded(lineBuf, false);
+                    lap(writeNs);
+                } else if (file) {
+                    CSLOG_PROFILE_BEGIN(writeBegin);
+                    fileBuf += lineBuf;
+                    CSLOG_PROFILE_END(WorkerStage::FileBuffer, writeBegin);
+                    currentSize += lineBuf.size();
+                    bytesWritten.fetch_add(lineBuf.size(), std::memory_order_relaxed);
+                    lap(writeNs);
+
+                    if (task.lvl <= LOG_LEVEL_ERROR || flushEachRecord) {
+                        flushFile();
+                        lastFlush = steady_clock::now();
+                    }
+
+                    rotate();
+                }
+            } else {
+                lap(writeNs);
+            }
+
+            writtenCount.fetch_add(1, std::memory_order_relaxed);
+            if (task.lvl >= LOG_LEVEL_ERROR && task.lvl <= LOG_LEVEL_DEBUG) {
+                writtenByLevel[task.lvl].fetch_add(1, std::memory_order_relaxed);
+            }
+
+            // 诊断记录（含调用点汇总本身）与缺口标记都不是用户语句产生的，不计入
+            if (countSites && !isDiag && task.kind == TaskKind::Record) {
+                SiteCount& sc = siteCounts[task.site];
+                ++sc.records;
+                sc.bytes += consoleText->size();
+            }
+            if (limitSites && task.site) {
+                ++siteRate[task.site];
+            }
+        }
+
+        if (cfg.toFile && file) {
+            bool needFlush = false;
+
+            if (fileBuf.size() >= FLUSH_BYTES_THRESHOLD) {
+                needFlush = true;
+            } else {
+                auto now = steady_clock::now();
+                if (duration_cast<milliseconds>(now - lastFlush).count() >= FLUSH_INTERVAL_MS) {
+                    needFlush = true;
+                }
+            }
+
+            if (needFlush) {
+                flushFile();
+                lastFlush = steady_clock::now();
+            }
+        }
+
+        if (degraded.load(std::memory_order_relaxed) && steadyNowNs() >= retryAtNs) {
+            tryResume();
+            lastFlush = steady_clock::now();
+        }
+
+        if (barrier) {
+            if (cfg.toFile && file) {
+                flushFile(true);
+                lastFlush = steady_clock::now();
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                completeFlush(barrier);
+            }
+            runWaiters(readyWaiters);
+        }
+
+        {
+            auto now = steady_clock::now();
+            if (duration_cast<milliseconds>(now - lastCalibrate).count() >= CALIBRATE_INTERVAL_MS) {
+                tickClock->calibrate();
+                lastCalibrate = now;
+            }
+        }
+
+        if (!cfg.metricsFile.empty()) {
+            int64_t now = steadyNowNs();
+            if (now - lastMetricsNs >= int64_t(cfg.metricsIntervalSec > 0 ? cfg.metricsIntervalSec : 10) * 1000000000) {
+                writeMetrics();
+                lastMetricsNs = now;
+            }
+        }
+
+        if (producerSamples) {
+            auto now = steady_clock::now();
+            if (duration_cast<milliseconds>(now - lastReport).count() >= REPORT_INTERVAL_MS) {
+                reportProducerSamples();
+                lastReport = now;
+            }
+        }
+
+        if (countSites) {
+            auto now = steady_clock::now();
+            if (duration_cast<seconds>(now - lastSiteReport).count() >= cfg.callsiteReportSec) {
+                reportCallsites(cfg.callsiteReportSec);
+                lastSiteReport = now;
+            }
+        }
+
+        {
+            auto now = steady_clock::now();
+            if (duration_cast<seconds>(now - lastRateReport).count() >= RATE_REPORT_SEC) {
+                reportRateLimited(RATE_REPORT_SEC);
+                lastRateReport = now;
+            }
+        }
+
+        if (limitSites) {
+            auto now = steady_clock::now();
+            auto elapsedMs = duration_cast<milliseconds>(now - lastSiteLimit).count();
+            if (elapsedMs >= 1000) {
+                limitCallsites(elapsedMs);
+                lastSiteLimit = now;
+            }
+        }
+
+        if (traceFile.is_open()) {
+            auto now = steady_clock::now();
+            if (duration_cast<milliseconds>(now - lastTraceFlush).count() >= FLUSH_INTERVAL_MS) {
+                traceFile.flush();
+                lastTraceFlush = now;
+            }
+        }
+
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            admitParked();
+            cv.notify_all();
+        }
+        runWaiters(readyWaiters);
+        runWaiters(abandonedWaiters);
+    }
+
+    // 退出前再尝试一次恢复，尽量不丢内存中暂存的记录；stop(deadline) 已到期则不再尝试
+    if (degraded.load(std::memory_order_relaxed)) {
+        if (!exitDeadlineNs || steadyNowNs() < exitDeadlineNs) {
+            tryResume();
+        }
+        if (degraded.load(std::memory_order_relaxed)) {
+            abandonedCount.fetch_add(degradedRing.size(), std::memory_order_relaxed);
+        }
+    }
+
+    if (cfg.toFile) {
+        flushFile();
+    }
+
+    closeTrace();
+    releaseCallsites();
+
+    if (!cfg.metricsFile.empty()) {
+        writeMetrics();
+    }
+}
+
+// Prometheus 文本格式的标签值只转义反斜杠、双引号与换行，其余字符（含制表符等控制字符）原样输出
+static void appendPromLabelEscaped(std::string& out, std::string_view s)
+{
+    for (char c : s) {
+        switch (c) {
+            case '\\': out += "\\\\"; break;
+            case '"':  out += "\\\""; break;
+            case '\n': out += "\\n";  break;
+            default:   out += c;
+        }
+    }
+}
+
+// 先写临时文件再改名，采集方不会读到写了一半的内容
+void Logger::Impl::writeMetrics()
+{
+    const LogStats st = owner.stats();
+
+    std::string label = "logger=\"";
+    appendPromLabelEscaped(label, cfg.baseName);
+    label += '"';
+
+    std::string out;
+    auto metric = [&](const char* name, const char* type, const char* help) {
+        out += "# HELP ";
+        out += name;
+        out += ' ';
+        out += help;
+        out += "\n# TYPE ";
+        out += name;
+        out += ' ';
+        out += type;
+        out += '\n';
+    };
+    auto sample = [&](const char* name, const std::string& labels, double value) {
+        char buf[64];
+        std::snprintf(buf, sizeof(buf), "%.17g", value);
+        out += name;
+        out += '{';
+        out += labels;
+        out += "} ";
+        out += buf;
+        out += '\n';
+    };
+
+    metric("cslog_records_total", "counter", "Records written, by level.");
+    const char* levels[] = {"error", "warn", "info", "debug"};
+    for (int i = 0; i < 4; ++i) {
+        sample("cslog_records_total", label + ",level=\"" + levels[i] + "\"", double(st.writtenByLevel[i]));
+    }
+
+    metric("cslog_enqueued_total", "counter", "Records accepted into the queue.");
+    sample("cslog_enqueued_total", label, double(st.enqueued));
+
+    metric("cslog_dropped_total", "counter", "Records dropped because the queue was full.");
+    sample("cslog_dropped_total", label, double(st.dropped));
+
+    metric("cslog_rate_limited_total", "counter", "Records dropped by the per-level rate limit, by level.");
+    for (int i = 0; i < 4; ++i) {
+        sample("cslog_rate_limited_total", label + ",level=\"" + levels[i] + "\"", double(st.rateLimited[i]));
+    }
+
+    metric("cslog_blocked_total", "counter", "Pushes that waited for queue space under the block policy.");
+    sample("cslog_blocked_total", label, double(st.blocked));
+
+    metric("cslog_blocked_seconds_total", "counter", "Time producers spent waiting for queue space.");
+    sample("cslog_blocked_seconds_total", label, double(st.blockedNs) / 1e9);
+
+    metric("cslog_queue_depth", "gauge", "Records currently queued.");
+    sample("cslog_queue_depth", label, double(st.queueDepth));
+
+    metric("cslog_queue_depth_max", "gauge", "Highest queue depth observed.");
+    sample("cslog_queue_depth_max", label, double(st.maxQueueDepth));
+
+    metric("cslog_bytes_written_total", "counter", "Bytes written to log files.");
+    sample("cslog_bytes_written_total", label, double(st.bytesWritten));
+
+    metric("cslog_rotations_total", "counter", "Log file rotations.");
+    sample("cslog_rotations_total", label, double(st.rotations));
+
+    metric("cslog_flushes_total", "counter", "File flushes.");
+    sample("cslog_flushes_total", label, double(st.flushes));
+
+    metric("cslog_flush_seconds_total", "counter", "Time spent in file flushes.");
+    sample("cslog_flush_seconds_total", label, double(st.flushNs) / 1e9);
+
+    metric("cslog_io_errors_total", "counter", "Log file open, write and flush failures.");
+    sample("cslog_io_errors_total", label, double(st.ioErrors));
+
+    metric("cslog_degraded", "gauge", "1 while file output is degraded to the in-memory buffer.");
+    sample("cslog_degraded", label, st.degraded ? 1.0 : 0.0);
+
+    metric("cslog_degraded_entries_total", "counter", "Times the logger entered degraded mode.");
+    sample("cslog_degraded_entries_total", label, double(st.degradedEntries));
+
+    metric("cslog_degraded_buffer_bytes", "gauge", "Bytes held in the degraded-mode buffer.");
+    sample("cslog_degraded_buffer_bytes", label, double(st.degradedBuffered));
+
+    metric("cslog_degraded_dropped_total", "counter", "Oldest buffered lines dropped while degraded.");
+    sample("cslog_degraded_dropped_total", label, double(st.degradedDropped));
+
+    metric("cslog_emergency_deletes_total", "counter", "Old log files deleted because the disk was full.");
+    sample("cslog_emergency_deletes_total", label, double(st.emergencyDeletes));
+
+    metric("cslog_abandoned_total", "counter", "Records abandoned because stop() reached its deadline.");
+    sample("cslog_abandoned_total", label, double(st.abandoned));
+
+    const std::string tmp = cfg.metricsFile + ".tmp";
+    std::FILE* fp = std::fopen(tmp.c_str(), "wb");
+    if (!fp) return;
+
+    std::fwrite(out.data(), 1, out.size(), fp);
+    std::fclose(fp);
+
+    std::error_code ec;
+    std::filesystem::rename(tmp, cfg.metricsFile, ec);
+}
+
+bool Logger::flush(std::chrono::milliseconds timeout)
+{
+    return impl->flush(timeout);
+}
+
+bool Logger::Impl::flush(std::chrono::milliseconds timeout)
+{
+    // 后台线程等待自己只会超时
+    if (std::this_thread::get_id() == worker.get_id()) return false;
+
+    std::unique_lock<std::mutex> lock(mtx);
+    if (exitFlag || !worker.joinable()) return false;
+
+    const uint64_t target = queuedTotal;
+    if (flushTarget < target) flushTarget = target;
+    const uint64_t req = ++flushReq;
+    cv.notify_one();
+
+    const bool done = flushCv.wait_for(lock, timeout, [&] { return flushDone >= req || exitFlag; });
+    return done && flushDone >= req && flushOk && target <= abandonedFrom;
+}
+
+bool Logger::pushAsync(LogTask&& task, AsyncDone done, void* arg)
+{
+    if (!enabled(task.lvl))
+        return true;
+
+    // 协程前端在挂起前构造任务，线程号在此补上
+    if (!task.tid) task.tid = currentThreadId();
+
+    return impl->enqueueAsync(std::move(task), done, arg);
+}
+
+bool Logger::flushAsync(AsyncDone done, void* arg)
+{
+    return impl->flushAsync(done, arg);
+}
+
+bool Logger::Impl::flushAsync(Logger::AsyncDone done, void* arg)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    if (exitFlag || !worker.joinable()) return false;
+
+    if (flushTarget < queuedTotal) flushTarget = queuedTotal;
+
+    AsyncWaiter w;
+    w.done = done;
+    w.arg  = arg;
+    w.req    = ++flushReq;
+    w.target = queuedTotal;
+    flushWaiters.push_back(w);
+
+    // 在后台线程上登记时（协程在后台线程上恢复后再次等待）本轮末尾即会处理，无需唤醒
+    if (std::this_thread::get_id() != worker.get_id()) cv.notify_one();
+    return true;
+}
+
+void Logger::stop()
+{
+    impl->stop(0);
+}
+
+uint64_t Logger::stop(std::chrono::steady_clock::time_point deadline)
+{
+    using namespace std::chrono;
+    // 0 表示不限期，早于纪元的期限按“已过期”处理
+    const int64_t ns = duration_cast<nanoseconds>(deadline.time_since_epoch()).count();
+    return impl->stop(std::max<int64_t>(ns, 1));
+}
+
+uint64_t Logger::Impl::stop(int64_t deadlineNs)
+{
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (!exitFlag) exitDeadlineNs = deadlineNs;
+        exitFlag = true;
+    }
+    cv.notify_all();
+    flushCv.notify_all();
+
+    const uint64_t before = abandonedCount.load(std::memory_order_relaxed);
+    if (worker.joinable()) worker.join();
+    closeFile();
+
+    // 停止时仍未完成的异步刷新按失败回调
+    std::vector<AsyncWaiter> pending;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        pending.swap(flushWaiters);
+    }
+    for (AsyncWaiter& w : pending) w.ok = false;
+    runWaiters(pending);
+
+#ifdef CSLOG_PROFILE_WORKER
+    dumpProfile();
+#endif
+    return abandonedCount.load(std::memory_order_relaxed) - before;
+}
+
+#ifdef CSLOG_PROFILE_WORKER
+void Logger::Impl::dumpProfile()
+{
+    if (profileDumped) return;
+    profileDumped = true;
+
+    std::cerr << "[PROFILE] 日志后台线程各阶段耗时（"
+#ifdef CSLOG_HAS_RDTSC
+              << "TSC 周期"
+#else
+              << "纳秒"
+#endif
+              << "）: " << cfg.baseName << "\n";
+
+    for (size_t i = 0; i < static_cast<size_t>(WorkerStage::Count); ++i) {
+        LatencyHistogram h = profile[i].snapshot();
+        if (h.count() == 0) continue;
+
+        std::cerr << "  " << workerStageName(static_cast<WorkerStage>(i))
+                  << " count=" << h.count()
+                  << " mean=" << static_cast<uint64_t>(h.mean())
+                  << " p50=" << h.percentile(0.50)
+                  << " p99=" << h.percentile(0.99)
+                  << " p999=" << h.percentile(0.999)
+                  << " max=" << h.max()
+                  << "\n";
+    }
+}
+#endif
+
+bool Logger::workerProfile(WorkerStage stage, LatencyHistogram& out) const
+{
+#ifdef CSLOG_PROFILE_WORKER
+    if (stage >= WorkerStage::Count) return false;
+    out = impl->profile[static_cast<size_t>(stage)].snapshot();
+    return true;
+#else
+    (void)stage;
+    (void)out;
+    return false;
+#endif
+}
+
+uint64_t Logger::Impl::beginSample()
+{
+    static thread_local uint32_t counter = 0;
+
+    int every = sampleEvery.load(std::memory_order_acquire);
+    if (every <= 0 || ++counter % static_cast<uint32_t>(every) != 0) return 0;
+
+    return static_cast<uint64_t>(steadyNowNs());
+}
+
+void Logger::Impl::reportProducerSamples()
+{
+    LatencyHistogram construct = producerSamples->construct.drain();
+    LatencyHistogram stream    = producerSamples->stream.drain();
+    LatencyHistogram finish    = producerSamples->finish.drain();
+    LatencyHistogram push      = producerSamples->push.drain();
+
+    if (construct.count() == 0) return;
+
+    std::string text = "producer_latency_ns samples=" + std::to_string(construct.count()) +
+                       " every=" + std::to_string(sampleEvery.load(std::memory_order_relaxed));
+
+    auto append = [&](const char* name, const LatencyHistogram& h) {
+        text += ' ';
+        text += name;
+        text += "_p50=" + std::to_string(h.percentile(0.50));
+        text += ' ';
+        text += name;
+        text += "_p99=" + std::to_string(h.percentile(0.99));
+        text += ' ';
+        text += name;
+        text += "_max=" + std::to_string(h.max());
+    };
+    append("construct", construct);
+    append("stream",    stream);
+    append("finish",    finish);
+    append("push",      push);
+
+    diag(LOG_LEVEL_INFO, std::move(text));
+}
+
+// 按记录数取前 callsiteTopN 个调用点，汇总为一条 INFO 记录后清零，下一个窗口重新计数
+void Logger::Impl::reportCallsites(int windowSec)
+{
+    if (siteCounts.empty()) return;
+
+    std::vector<std::pair<const CallSite*, SiteCount>> sites(siteCounts.begin(), siteCounts.end());
+    siteCounts.clear();
+
+    uint64_t records = 0;
+    uint64_t bytes   = 0;
+    for (const auto& s : sites) {
+        records += s.second.records;
+        bytes   += s.second.bytes;
+    }
+
+    size_t topN = static_cast<size_t>(cfg.callsiteTopN > 0 ? cfg.callsiteTopN : 10);
+    if (topN > sites.size()) topN = sites.size();
+    std::partial_sort(sites.begin(), sites.begin() + topN, sites.end(), [](const auto& a, const auto& b) {
+        return a.second.records > b.second.records;
+    });
+
+    std::string text = "hot_callsites window_s=" + std::to_string(windowSec) +
+                       " sites=" + std::to_string(sites.size()) +
+                       " records=" + std::to_string(records) +
+                       " bytes=" + std::to_string(bytes);
+
+    char pct[16];
+    for (size_t i = 0; i < topN; ++i) {
+        const CallSite*  site = sites[i].first;
+        const SiteCount& sc   = sites[i].second;
+
+        text += " | ";
+        if (site) {
+            text += site->file;
+            text += ':';
+            text += std::to_string(site->line);
+        } else {
+            text += "<push>";
+        }
+        std::snprintf(pct, sizeof(pct), "%.1f", 100.0 * double(sc.records) / double(records));
+        text += " records=" + std::to_string(sc.records) +
+                " bytes=" + std::to_string(sc.bytes) +
+                " pct=" + pct;
+    }
+
+    diag(LOG_LEVEL_INFO, std::move(text));
+}
+
+bool Logger::Impl::takeToken(LogLevel lvl)
+{
+    if (lvl < LOG_LEVEL_ERROR || lvl > LOG_LEVEL_DEBUG) return true;
+
+    RateGate& g = rateGates[lvl];
+    const int64_t interval = g.intervalNs.load(std::memory_order_relaxed);
+    if (interval == 0) return true;
+
+    const int64_t burst = g.burstNs.load(std::memory_order_relaxed);
+    const int64_t now   = steadyNowNs();
+
+    int64_t tat = g.tat.load(std::memory_order_relaxed);
+    int64_t next;
+    do {
+        next = std::max(tat, now) + interval;
+        if (next - now > burst) {
+            g.dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+    } while (!g.tat.compare_exchange_weak(tat, next, std::memory_order_relaxed));
+
+    return true;
+}
+
+// 窗口内有限速丢弃时输出一条 WARN 汇总；汇总本身由后台线程直接入队，不经过限速
+void Logger::Impl::reportRateLimited(int windowSec)
+{
+    static const char* names[] = {"error", "warn", "info", "debug"};
+
+    std::string text;
+    for (int i = 0; i < 4; ++i) {
+        const uint64_t total = rateGates[i].dropped.load(std::memory_order_relaxed);
+        const uint64_t delta = total - rateReported[i];
+        rateReported[i] = total;
+        if (delta == 0) continue;
+
+        text += ' ';
+        text += names[i];
+        text += '=';
+        text += std::to_string(delta);
+    }
+    if (text.empty()) return;
+
+    diag(LOG_LEVEL_WARN, "rate_limited window_s=" + std::to_string(windowSec) + text);
+}
+
+static std::string callsiteName(const CallSite* site)
+{
+    return std::string(site->file) + ":" + std::to_string(site->line);
+}
+
+// 每秒按实际速率调整各调用点的采样倍数；进入与退出限流各输出一条提示
+void Logger::Impl::limitCallsites(int64_t elapsedMs)
+{
+    const uint64_t limit = static_cast<uint64_t>(cfg.callsiteRateLimit);
+
+    // 已限流但本周期没有记录的调用点也要参与判断，才能恢复
+    for (const auto& t : throttled) {
+        siteRate.emplace(t.first, 0);
+    }
+
+    for (const auto& r : siteRate) {
+        const CallSite* site = r.first;
+        auto            it   = throttled.find(site);
+
+        if (it == throttled.end()) {
+            const uint64_t rate = r.second * 1000 / static_cast<uint64_t>(elapsedMs);
+            if (rate <= limit) continue;
+
+            Throttle& t = throttled[site];
+            t.every   = static_cast<uint32_t>((rate + limit - 1) / limit);
+            t.lastSeq = site->sampleSeq.load(std::memory_order_relaxed);
+            site->sampleEvery.store(t.every, std::memory_order_relaxed);
+
+            diag(LOG_LEVEL_WARN, "调用点 " + callsiteName(site) + " 约 " + std::to_string(rate) +
+                                 " 条/秒，超过 callsiteRateLimit=" + std::to_string(limit) +
+                                 "，改为每 " + std::to_string(t.every) + " 条输出 1 条");
+            continue;
+        }
+
+        Throttle&      t        = it->second;
+        const uint32_t seq      = site->sampleSeq.load(std::memory_order_relaxed);
+        const uint64_t attempts = static_cast<uint32_t>(seq - t.lastSeq);
+        const uint64_t rate     = attempts * 1000 / static_cast<uint64_t>(elapsedMs);
+
+        t.lastSeq     = seq;
+        t.sampledOut += attempts - attempts / t.every;
+
+        if (rate < limit / 2) {
+            site->sampleEvery.store(0, std::memory_order_relaxed);
+            diag(LOG_LEVEL_INFO, "调用点 " + callsiteName(site) + " 回落到约 " + std::to_string(rate) +
+                                 " 条/秒，恢复全量输出，限流期间约 " + std::to_string(t.sampledOut) +
+                                 " 条未输出");
+            throttled.erase(it);
+        } else {
+            t.every = static_cast<uint32_t>(std::max<uint64_t>((rate + limit - 1) / limit, 2));
+            site->sampleEvery.store(t.every, std::memory_order_relaxed);
+        }
+    }
+
+    siteRate.clear();
+}
+
+// 调用点对象是全局静态的，停止时撤销本实例设置的采样
+void Logger::Impl::releaseCallsites()
+{
+    for (const auto& t : throttled) {
+        t.first->sampleEvery.store(0, std::memory_order_relaxed);
+    }
+    throttled.clear();
+}
+
+uint64_t LogLine::beginSample(Logger* target)
+{
+    if (!target) target = g_default.load(std::memory_order_acquire);
+    return target ? target->impl->beginSample() : 0;
+}
+
+LogLine::LogLine(LogLevel lvl, const char* file, int line, const char* func, const CallSite* site)
+    : site(site), sampleBegin(beginSample(nullptr)), level(lvl), fileName(file), lineNum(line), funcName(func)
+{
+    admit();
+    if (sampleBegin) sampleBuilt = static_cast<uint64_t>(steadyNowNs());
+}
+
+LogLine::LogLine(LogLevel lvl, const CallSite* site)
+    : site(site), sampleBegin(beginSample(nullptr)), level(lvl)
+{
+    admit();
+    if (sampleBegin) sampleBuilt = static_cast<uint64_t>(steadyNowNs());
+}
+
+LogLine::LogLine(Logger& logger, LogLevel lvl, const char* file, int line, const char* func, const CallSite* site)
+    : logger(&logger), site(site), sampleBegin(beginSample(&logger)), level(lvl), fileName(file), lineNum(line), funcName(func)
+{
+    admit();
+    if (sampleBegin) sampleBuilt = static_cast<uint64_t>(steadyNowNs());
+}
+
+LogLine::LogLine(Logger& logger, LogLevel lvl, const CallSite* site)
+    : logger(&logger), site(site), sampleBegin(beginSample(&logger)), level(lvl)
+{
+    admit();
+    if (sampleBegin) sampleBuilt = static_cast<uint64_t>(steadyNowNs());
+}
+
+// 被调用点采样或等级限速跳过的语句让 ostream 进入失败状态，后续 << 不再做格式化
+void LogLine::admit()
+{
+    Logger* target = logger ? logger : g_default.load(std::memory_order_acquire);
+
+    if ((site && callsiteSampledOut(site)) || (target && !target->impl->takeToken(level))) {
+        skipped = true;
+        os.setstate(std::ios::badbit);
+    }
+}
+
+LogLine::~LogLine()
+{
+    if (skipped)
+        return;
+
+    Logger& target = logger ? *logger : Logger::instance();
+
+    if (!target.enabled(level))
+        return;
+
+    const uint64_t streamEnd = sampleBegin ? static_cast<uint64_t>(steadyNowNs()) : 0;
+
+    LogTask task;
+    task.lvl   = level;
+    task.ticks = target.now(task.clockMode);
+    task.file  = fileName;
+    task.line  = lineNum;
+    task.func  = funcName;
+    task.site  = site;
+    task.tid   = currentThreadId();
+    buf.finish();
+    task.text  = std::move(text);
+
+    while (!task.text.empty() && (task.text.back() == '\n' || task.text.back() == '\r')) {
+        task.text.pop_back();
+    }
+
+    if (!sampleBegin) {
+        target.push(std::move(task));
+        return;
+    }
+
+    const uint64_t pushBegin = static_cast<uint64_t>(steadyNowNs());
+    target.push(std::move(task));
+    const uint64_t pushEnd   = static_cast<uint64_t>(steadyNowNs());
+
+    // producerSamples 一经创建不再释放
+    if (auto* samples = target.impl->producerSamples.get()) {
+        samples->construct.record(sampleBuilt - sampleBegin);
+        samples->stream.record(streamEnd - sampleBuilt);
+        samples->finish.record(pushBegin - streamEnd);
+        samples->push.record(pushEnd - pushBegin);
+    }
+}
+
+ScopeTimer::ScopeTimer(const char* name)
+    : ScopeTimer(Logger::instance(), name)
+{
+}
+
+ScopeTimer::ScopeTimer(Logger& logger, const char* name)
+    : logger(logger), name(name)
+{
+    if (logger.traceEnabled()) {
+        beginTicks = logger.now(clockMode);
+    }
+}
+
+ScopeTimer::~ScopeTimer()
+{
+    if (beginTicks == 0) return;
 
-    out << ",\"msg\":\"" << jsonEscape(msg) << "\"";
-    out << "}\n";
+    uint8_t endMode = 0;
+    uint64_t endTicks = logger.now(endMode);
+    if (endMode != clockMode) return;
 
-    Logger::instance().push(level, out.str());
+    logger.pushSpan(name, beginTicks, endTicks, clockMode);
 }
 
 } // namespace csLog